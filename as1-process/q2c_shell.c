@@ -1,62 +1,1805 @@
 // cpsc-351-ostep/as1/q2c.c
+//
+// Tiny fork/exec shell.
+// -------------------------------------------------------
+// Build:
+//   gcc -Wall -Wextra -O2 -std=c17 -o shell q2c_shell.c
+//
+// Run:
+//   ./shell                  interactive
+//   ./shell -j 8 < cmds.txt  batch: up to 8 commands in flight (-g groups
+//                            each command's output together)
+//   ./shell -l log.jsonl     append one JSON object per finished command
+//   ./shell -p 4 [-r idle]   keep 4 pre-forked helpers ready to exec
+//                            (refill eagerly after each launch, or only
+//                            while idle/waiting)
+//   ./shell -E               always exec external echo/cat/pwd/true/false
+//
+// Supports:
+//   - multi-argument commands          ls -l /tmp
+//   - quoting                          echo "a b" 'c d' e\ f
+//   - N-stage pipelines                cat file | grep x | wc -l
+//   - redirection                      sort < in > out,  cmd >> log
+//   - input lines of any length (getline)
+//   - PATH lookup cache                hash, hash -r, hash -s
+//   - background jobs                  sleep 5 &, jobs, wait, wait %1
+//   - resource accounting              time cmd, stats
+//   - pre-forked launch pool           pool
+//   - in-process builtins              cd, pwd, echo, true, false, cat
 
+#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE                 // wait4(), copy_file_range()
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
+#include <sys/resource.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
 #include <sys/wait.h>
 
-int main(){
-    
-    char  input[100];
+// ============================================================================
+//                                CONFIGURATION
+// ============================================================================
+#define PROMPT "cmd> "
+#define HASH_BUCKETS 256   // command-path cache buckets (power of two)
+#define REAP_RING    256   // exit statuses buffered by the SIGCHLD handler
+#define HIST_BUCKETS 24    // stats histogram: [0,1ms), [1,2ms), ... doubling
+#define POOL_MSG_MAX 65536 // largest argv+redirections a pool helper accepts
+
+// A token is either a word (argv entry / file name) or an operator.
+typedef enum { TOK_WORD, TOK_PIPE, TOK_IN, TOK_OUT, TOK_APPEND, TOK_AMP } tok_type_t;
+
+typedef struct {
+    tok_type_t type;
+    char      *text;       // only set for TOK_WORD (heap, owned)
+} token_t;
+
+typedef struct {
+    token_t *v;
+    size_t   n, cap;
+} tokens_t;
+
+// One stage of a pipeline: argv plus optional redirections.
+typedef struct {
+    char  **argv;          // NULL-terminated, points into the token texts
+    size_t  argc, cap;
+    char   *in_file;       // "< file"
+    char   *out_file;      // "> file" or ">> file"
+    int     append;
+    const char *path;      // resolved executable (owned by the path cache)
+} cmd_t;
+
+typedef struct {
+    cmd_t  *cmds;
+    size_t  n;
+    int     background;    // trailing '&'
+} pipeline_t;
+
+// ============================================================================
+//                              SMALL HELPERS
+// ============================================================================
+static void *xrealloc(void *p, size_t n) {
+    void *q = realloc(p, n);
+    if (!q) {
+        perror("realloc");
+        exit(-1);
+    }
+    return q;
+}
+
+static void tokens_push(tokens_t *t, tok_type_t type, char *text) {
+    if (t->n == t->cap) {
+        t->cap = t->cap ? t->cap * 2 : 16;
+        t->v   = xrealloc(t->v, t->cap * sizeof(*t->v));
+    }
+    t->v[t->n].type = type;
+    t->v[t->n].text = text;
+    t->n++;
+}
+
+static void tokens_free(tokens_t *t) {
+    for (size_t i = 0; i < t->n; i++)
+        free(t->v[i].text);
+    free(t->v);
+    memset(t, 0, sizeof(*t));
+}
+
+static void cmd_push_arg(cmd_t *c, char *arg) {
+    if (c->argc + 2 > c->cap) {            // room for arg + NULL terminator
+        c->cap  = c->cap ? c->cap * 2 : 8;
+        c->argv = xrealloc(c->argv, c->cap * sizeof(*c->argv));
+    }
+    c->argv[c->argc++] = arg;
+    c->argv[c->argc]   = NULL;
+}
+
+static void pipeline_free(pipeline_t *p) {
+    for (size_t i = 0; i < p->n; i++)
+        free(p->cmds[i].argv);
+    free(p->cmds);
+    memset(p, 0, sizeof(*p));
+}
+
+// ============================================================================
+//                                TOKENIZER
+// ----------------------------------------------------------------------------
+// Splits a line into words and operators.
+//   - whitespace separates words
+//   - '...' is literal, "..." allows \" and \\ escapes, \x escapes x
+//   - | < > >> & are operators unless quoted
+// Returns 0 on success, -1 on an unterminated quote.
+// ============================================================================
+static int tokenize(const char *line, tokens_t *out) {
+    const char *p = line;
+
+    while (*p) {
+        // skip whitespace
+        while (*p == ' ' || *p == '\t' || *p == '\n')
+            p++;
+        if (!*p)
+            break;
+
+        // operators
+        if (*p == '|') { tokens_push(out, TOK_PIPE, NULL); p++; continue; }
+        if (*p == '<') { tokens_push(out, TOK_IN,   NULL); p++; continue; }
+        if (*p == '&') { tokens_push(out, TOK_AMP,  NULL); p++; continue; }
+        if (*p == '>') {
+            if (p[1] == '>') { tokens_push(out, TOK_APPEND, NULL); p += 2; }
+            else             { tokens_push(out, TOK_OUT,    NULL); p++;    }
+            continue;
+        }
+
+        // word: accumulate until an unquoted separator
+        size_t len = 0, cap = 32;
+        char  *w   = xrealloc(NULL, cap);
+
+        while (*p && !strchr(" \t\n|<>&", *p)) {
+            char c = *p++;
+
+            if (c == '\'' || c == '"') {
+                char quote = c;
+                while (*p && *p != quote) {
+                    c = *p++;
+                    if (quote == '"' && c == '\\' && (*p == '"' || *p == '\\'))
+                        c = *p++;
+                    if (len + 1 >= cap) w = xrealloc(w, cap *= 2);
+                    w[len++] = c;
+                }
+                if (*p != quote) {
+                    fprintf(stderr, "shell: unterminated %c quote\n", quote);
+                    free(w);
+                    return -1;
+                }
+                p++; // closing quote
+                continue;
+            }
+            if (c == '\\' && *p)
+                c = *p++;
+
+            if (len + 1 >= cap) w = xrealloc(w, cap *= 2);
+            w[len++] = c;
+        }
+        w[len] = '\0';
+        tokens_push(out, TOK_WORD, w);
+    }
+    return 0;
+}
+
+// ============================================================================
+//                                 PARSER
+// ----------------------------------------------------------------------------
+// Groups tokens into pipeline stages. Word texts stay owned by the token list,
+// cmd_t.argv only borrows them.
+// Returns 0 on success, -1 on a syntax error (message already printed).
+// ============================================================================
+static int parse(tokens_t *t, pipeline_t *p) {
+    size_t cap = 4;
+    p->cmds = xrealloc(NULL, cap * sizeof(*p->cmds));
+    p->n    = 1;
+    memset(&p->cmds[0], 0, sizeof(cmd_t));
+
+    for (size_t i = 0; i < t->n; i++) {
+        cmd_t *c = &p->cmds[p->n - 1];
+
+        switch (t->v[i].type) {
+        case TOK_WORD:
+            cmd_push_arg(c, t->v[i].text);
+            break;
+
+        case TOK_PIPE:
+            if (c->argc == 0) {
+                fprintf(stderr, "shell: syntax error near '|'\n");
+                return -1;
+            }
+            if (p->n == cap)
+                p->cmds = xrealloc(p->cmds, (cap *= 2) * sizeof(*p->cmds));
+            memset(&p->cmds[p->n++], 0, sizeof(cmd_t));
+            break;
+
+        case TOK_IN:
+        case TOK_OUT:
+        case TOK_APPEND:
+            if (i + 1 >= t->n || t->v[i + 1].type != TOK_WORD) {
+                fprintf(stderr, "shell: redirection needs a file name\n");
+                return -1;
+            }
+            if (t->v[i].type == TOK_IN) {
+                c->in_file = t->v[i + 1].text;
+            } else {
+                c->out_file = t->v[i + 1].text;
+                c->append   = (t->v[i].type == TOK_APPEND);
+            }
+            i++; // consumed the file name
+            break;
+
+        case TOK_AMP:
+            if (i + 1 != t->n || c->argc == 0) {
+                fprintf(stderr, "shell: syntax error near '&'\n");
+                return -1;
+            }
+            p->background = 1;
+            break;
+        }
+    }
+
+    if (p->cmds[p->n - 1].argc == 0) {
+        if (p->n > 1) {
+            fprintf(stderr, "shell: syntax error near '|'\n");
+            return -1;
+        }
+        p->n = 0; // empty line
+    }
+    return 0;
+}
+
+// ============================================================================
+//                           COMMAND PATH CACHE
+// ----------------------------------------------------------------------------
+// Like bash's `hash`: remembers where each command name was found on $PATH
+// so a launch is one execv() instead of one failed execve() per directory.
+//
+// The whole table is dropped when $PATH changes. A hit is checked with one
+// access(X_OK) first; an entry whose file is gone or no longer executable is
+// dropped and looked up again (and counted as a miss), so a stale path is
+// never handed to a child.
+// ============================================================================
+typedef struct path_entry {
+    char              *name;
+    char              *path;
+    unsigned long      hits;
+    struct path_entry *next;
+} path_entry_t;
+
+static struct {
+    path_entry_t *buckets[HASH_BUCKETS];
+    char         *path_env;    // copy of $PATH the entries were resolved with
+    unsigned long hits, misses;
+} pcache;
+
+static unsigned hash_str(const char *s) {
+    unsigned h = 2166136261u;  // FNV-1a
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h & (HASH_BUCKETS - 1);
+}
+
+static void pcache_clear(void) {
+    for (int i = 0; i < HASH_BUCKETS; i++) {
+        path_entry_t *e = pcache.buckets[i];
+        while (e) {
+            path_entry_t *next = e->next;
+            free(e->name);
+            free(e->path);
+            free(e);
+            e = next;
+        }
+        pcache.buckets[i] = NULL;
+    }
+}
+
+static void pcache_forget(const char *name) {
+    path_entry_t **pp = &pcache.buckets[hash_str(name)];
+    for (; *pp; pp = &(*pp)->next) {
+        if (strcmp((*pp)->name, name) == 0) {
+            path_entry_t *e = *pp;
+            *pp = e->next;
+            free(e->name);
+            free(e->path);
+            free(e);
+            return;
+        }
+    }
+}
+
+// Walks $PATH the way execvp() would. Returns a malloc'd path or NULL.
+static char *path_search(const char *name, const char *path_env) {
+    size_t nlen = strlen(name);
+    const char *dir = path_env;
+
+    while (dir) {
+        const char *end  = strchr(dir, ':');
+        size_t      dlen = end ? (size_t)(end - dir) : strlen(dir);
+
+        char *full = xrealloc(NULL, dlen + nlen + 3);
+        if (dlen == 0) {
+            strcpy(full, "./");                  // empty entry means cwd
+        } else {
+            memcpy(full, dir, dlen);
+            full[dlen] = '/';
+            full[dlen + 1] = '\0';
+        }
+        strcat(full, name);
+
+        struct stat st;
+        if (stat(full, &st) == 0 && S_ISREG(st.st_mode) && access(full, X_OK) == 0)
+            return full;
+
+        free(full);
+        dir = end ? end + 1 : NULL;
+    }
+    return NULL;
+}
+
+// Returns the cached (or freshly resolved) path for name, or NULL when the
+// command is not on $PATH. Names containing '/' are not cached.
+static const char *pcache_lookup(const char *name) {
+    const char *path_env = getenv("PATH");
+    if (!path_env)
+        path_env = "/usr/local/bin:/usr/bin:/bin";
+
+    if (!pcache.path_env || strcmp(pcache.path_env, path_env) != 0) {
+        pcache_clear();
+        free(pcache.path_env);
+        pcache.path_env = strdup(path_env);
+    }
+
+    unsigned b = hash_str(name);
+    for (path_entry_t *e = pcache.buckets[b]; e; e = e->next) {
+        if (strcmp(e->name, name) == 0) {
+            if (access(e->path, X_OK) != 0) {
+                pcache_forget(name);          // stale: search $PATH again
+                break;
+            }
+            e->hits++;
+            pcache.hits++;
+            return e->path;
+        }
+    }
+
+    pcache.misses++;
+    char *full = path_search(name, path_env);
+    if (!full)
+        return NULL;
+
+    path_entry_t *e = xrealloc(NULL, sizeof(*e));
+    e->name = strdup(name);
+    e->path = full;
+    e->hits = 0;
+    e->next = pcache.buckets[b];
+    pcache.buckets[b] = e;
+    return full;
+}
+
+// Forgets entries found through a relative $PATH entry (after cd).
+static void pcache_drop_relative(void) {
+    for (int i = 0; i < HASH_BUCKETS; i++) {
+        path_entry_t **pp = &pcache.buckets[i];
+        while (*pp) {
+            path_entry_t *e = *pp;
+            if (e->path[0] != '/') {
+                *pp = e->next;
+                free(e->name);
+                free(e->path);
+                free(e);
+            } else {
+                pp = &e->next;
+            }
+        }
+    }
+}
+
+// Called when a cached command exited 127: forget it if the file is gone.
+static void pcache_recheck(const char *name) {
+    for (path_entry_t *e = pcache.buckets[hash_str(name)]; e; e = e->next) {
+        if (strcmp(e->name, name) == 0) {
+            if (access(e->path, X_OK) != 0)
+                pcache_forget(name);
+            return;
+        }
+    }
+}
+
+// hash          list cached commands
+// hash -r       forget everything
+// hash -s       hit/miss counters
+static int builtin_hash(const cmd_t *c) {
+    if (c->argc > 1 && strcmp(c->argv[1], "-r") == 0) {
+        pcache_clear();
+        return 0;
+    }
+    if (c->argc > 1 && strcmp(c->argv[1], "-s") == 0) {
+        unsigned long total = pcache.hits + pcache.misses;
+        printf("hits: %lu  misses: %lu  hit rate: %.1f%%\n",
+               pcache.hits, pcache.misses,
+               total ? 100.0 * pcache.hits / total : 0.0);
+        return 0;
+    }
+
+    printf("hits\tcommand\n");
+    for (int i = 0; i < HASH_BUCKETS; i++)
+        for (path_entry_t *e = pcache.buckets[i]; e; e = e->next)
+            printf("%4lu\t%s\n", e->hits, e->path);
+    return 0;
+}
+
+// ============================================================================
+//                            IN-PROCESS UTILITIES
+// ----------------------------------------------------------------------------
+// The commands that dominate our scripts, run without fork+exec. A lone
+// foreground command runs right in the shell (redirections applied around
+// it); inside a pipeline or in the background it runs in the forked child,
+// which still saves the exec. -E turns this off so the external binaries can
+// be timed for comparison.
+// ============================================================================
+static int no_utils;   // -E
+
+static int util_true(const cmd_t *c)  { (void)c; return 0; }
+static int util_false(const cmd_t *c) { (void)c; return 1; }
+
+// echo [-n] args...
+static int util_echo(const cmd_t *c) {
+    size_t first   = 1;
+    int    newline = 1;
+    if (c->argc > 1 && strcmp(c->argv[1], "-n") == 0) {
+        newline = 0;
+        first   = 2;
+    }
+    for (size_t i = first; i < c->argc; i++)
+        printf(i > first ? " %s" : "%s", c->argv[i]);
+    if (newline)
+        putchar('\n');
+    fflush(stdout);
+    return 0;
+}
+
+static int util_pwd(const cmd_t *c) {
+    (void)c;
+    char *cwd = getcwd(NULL, 0);
+    if (!cwd) {
+        perror("pwd");
+        return 1;
+    }
+    printf("%s\n", cwd);
+    fflush(stdout);
+    free(cwd);
+    return 0;
+}
+
+// Copies in -> out entirely in the kernel when it can: copy_file_range()
+// between files, sendfile() from a file to anything, read/write otherwise.
+static int copy_fd(int in, int out) {
+    ssize_t n;
+
+    while ((n = copy_file_range(in, NULL, out, NULL, 1 << 30, 0)) > 0)
+        ;
+    if (n == 0)
+        return 0;
+    if (errno != EINVAL && errno != EXDEV && errno != ENOSYS && errno != EBADF)
+        return -1;
+
+    while ((n = sendfile(out, in, NULL, 1 << 30)) > 0)
+        ;
+    if (n == 0)
+        return 0;
+    if (errno != EINVAL && errno != ENOSYS)
+        return -1;
+
+    char buf[65536];
+    while ((n = read(in, buf, sizeof(buf))) != 0) {
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        for (ssize_t off = 0; off < n; ) {
+            ssize_t w = write(out, buf + off, (size_t)(n - off));
+            if (w < 0) {
+                if (errno == EINTR) continue;
+                return -1;
+            }
+            off += w;
+        }
+    }
+    return 0;
+}
+
+// cat [file | -]...
+static int util_cat(const cmd_t *c) {
+    int rc = 0;
+    fflush(stdout);
+
+    if (c->argc == 1)
+        return copy_fd(STDIN_FILENO, STDOUT_FILENO) == 0 ? 0 : 1;
+
+    for (size_t i = 1; i < c->argc; i++) {
+        const char *name = c->argv[i];
+        int fd = strcmp(name, "-") == 0 ? STDIN_FILENO : open(name, O_RDONLY);
+        if (fd == -1) {
+            fprintf(stderr, "cat: %s: %s\n", name, strerror(errno));
+            rc = 1;
+            continue;
+        }
+        if (copy_fd(fd, STDOUT_FILENO) == -1) {
+            fprintf(stderr, "cat: %s: %s\n", name, strerror(errno));
+            rc = 1;
+        }
+        if (fd != STDIN_FILENO)
+            close(fd);
+    }
+    return rc;
+}
+
+static const struct {
+    const char *name;
+    int       (*fn)(const cmd_t *);
+} utils[] = {
+    { "true",  util_true  },
+    { "false", util_false },
+    { "echo",  util_echo  },
+    { "pwd",   util_pwd   },
+    { "cat",   util_cat   },
+};
+
+static int is_util(const cmd_t *c) {
+    if (no_utils)
+        return 0;
+    for (size_t i = 0; i < sizeof(utils) / sizeof(utils[0]); i++)
+        if (strcmp(c->argv[0], utils[i].name) == 0)
+            return 1;
+    return 0;
+}
+
+// Returns the utility's exit status, or -1 when c is not one.
+static int run_util(const cmd_t *c) {
+    if (no_utils)
+        return -1;
+    for (size_t i = 0; i < sizeof(utils) / sizeof(utils[0]); i++)
+        if (strcmp(c->argv[0], utils[i].name) == 0)
+            return utils[i].fn(c);
+    return -1;
+}
+
+// Applies c's redirections to the shell itself, saving the old stdin/stdout
+// in saved[]. Returns -1 (and restores nothing) if a file cannot be opened.
+static int redirect_shell(const cmd_t *c, int saved[2]) {
+    saved[0] = saved[1] = -1;
+    fflush(stdout);
+
+    if (c->in_file) {
+        int fd = open(c->in_file, O_RDONLY);
+        if (fd == -1) {
+            perror(c->in_file);
+            return -1;
+        }
+        saved[0] = dup(STDIN_FILENO);
+        dup2(fd, STDIN_FILENO);
+        close(fd);
+    }
+    if (c->out_file) {
+        int flags = O_WRONLY | O_CREAT | (c->append ? O_APPEND : O_TRUNC);
+        int fd = open(c->out_file, flags, 0666);
+        if (fd == -1) {
+            perror(c->out_file);
+            if (saved[0] != -1) {
+                dup2(saved[0], STDIN_FILENO);
+                close(saved[0]);
+            }
+            return -1;
+        }
+        saved[1] = dup(STDOUT_FILENO);
+        dup2(fd, STDOUT_FILENO);
+        close(fd);
+    }
+    return 0;
+}
+
+static void restore_shell(int saved[2]) {
+    fflush(stdout);
+    for (int k = 0; k < 2; k++) {
+        if (saved[k] != -1) {
+            dup2(saved[k], k);
+            close(saved[k]);
+        }
+    }
+}
+
+// ============================================================================
+//                              CHILD SETUP
+// ----------------------------------------------------------------------------
+// Runs in the child after fork(): wire up stdin/stdout, apply redirections
+// (which win over the pipe, like sh), then exec. Never returns.
+// ============================================================================
+static void exec_stage(const cmd_t *c, int in_fd, int out_fd) {
+    if (in_fd != STDIN_FILENO) {
+        dup2(in_fd, STDIN_FILENO);
+        close(in_fd);
+    }
+    if (out_fd != STDOUT_FILENO) {
+        dup2(out_fd, STDOUT_FILENO);
+        close(out_fd);
+    }
+
+    if (c->in_file) {
+        int fd = open(c->in_file, O_RDONLY);
+        if (fd == -1) {
+            perror(c->in_file);
+            _exit(1);
+        }
+        dup2(fd, STDIN_FILENO);
+        close(fd);
+    }
+    if (c->out_file) {
+        int flags = O_WRONLY | O_CREAT | (c->append ? O_APPEND : O_TRUNC);
+        int fd = open(c->out_file, flags, 0666);
+        if (fd == -1) {
+            perror(c->out_file);
+            _exit(1);
+        }
+        dup2(fd, STDOUT_FILENO);
+        close(fd);
+    }
+
+    int rc = run_util(c);
+    if (rc != -1) {
+        fflush(stdout);
+        _exit(rc);
+    }
+
+    if (c->path) {
+        execv(c->path, c->argv);
+        if (errno != ENOENT)
+            perror(c->path);
+        // removed between the parent's lookup and now: full $PATH search
+        // (the parent re-checks the entry on its next lookup)
+    }
+    execvp(c->argv[0], c->argv);
+    perror(c->argv[0]);
+    _exit(127);
+}
+
+// ============================================================================
+//                                 JOBS
+// ----------------------------------------------------------------------------
+// Every launched pipeline is a job, foreground or background. Children are
+// reaped asynchronously: the SIGCHLD handler collects exit statuses into a
+// small ring, and the main loop applies them to the job table with SIGCHLD
+// blocked. SIGCHLD stays blocked except while reading input or suspended
+// waiting for a child, so the table is never touched from two places at once.
+// ============================================================================
+typedef struct {
+    pid_t  pid;
+    char  *name;        // argv[0], for path-cache re-checks
+    int    cached;      // launched through a path-cache entry
+    int    done;
+    int    status;      // raw wait status
+    struct rusage ru;   // from wait4()
+} proc_t;
+
+typedef struct job {
+    int         id;
+    int         background;
+    int         capture_fd;   // -1, or temp file holding the job's output
+    long        seq;          // batch mode: input line number
+    double      start, end;   // CLOCK_MONOTONIC seconds
+    char       *cmdline;
+    proc_t     *procs;
+    size_t      n, live;
+    struct job *next;
+} job_t;
+
+static void     pool_idle(void);  // PRE-FORKED POOL, below
+static void     pool_flush(void);
+
+static job_t   *jobs;            // sorted by id
+static sigset_t sigchld_only;    // { SIGCHLD }
+static sigset_t shell_mask;      // mask to use while waiting (SIGCHLD open)
+
+static struct {
+    pid_t           pid;
+    int             status;
+    struct timespec when;      // reap time, for per-command wall time
+    struct rusage   ru;
+} reap_ring[REAP_RING];
+static volatile sig_atomic_t reap_head, reap_tail;
+
+static void sigchld_handler(int sig) {
+    (void)sig;
+    int saved = errno;
+
+    while (reap_head - reap_tail < REAP_RING) {
+        int   slot = reap_head % REAP_RING;
+        int   st;
+        pid_t pid = wait4(-1, &st, WNOHANG, &reap_ring[slot].ru);
+        if (pid <= 0)
+            break;
+        reap_ring[slot].pid    = pid;
+        reap_ring[slot].status = st;
+        clock_gettime(CLOCK_MONOTONIC, &reap_ring[slot].when);
+        reap_head++;
+    }
+    errno = saved;
+}
+
+static double ts_sec(const struct timespec *ts) {
+    return ts->tv_sec + ts->tv_nsec / 1e9;
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts_sec(&ts);
+}
+
+static int job_status(const job_t *j) {
+    int st = j->procs[j->n - 1].status;   // like sh: last stage decides
+    return WIFEXITED(st) ? WEXITSTATUS(st) : 128 + WTERMSIG(st);
+}
+
+static void job_free(job_t *j) {
+    for (size_t i = 0; i < j->n; i++)
+        free(j->procs[i].name);
+    if (j->capture_fd != -1)
+        close(j->capture_fd);
+    free(j->procs);
+    free(j->cmdline);
+    free(j);
+}
+
+static void job_remove(job_t *j) {
+    for (job_t **pp = &jobs; *pp; pp = &(*pp)->next) {
+        if (*pp == j) {
+            *pp = j->next;
+            job_free(j);
+            return;
+        }
+    }
+}
+
+static job_t *job_find(int id) {
+    for (job_t *j = jobs; j; j = j->next)
+        if (j->id == id)
+            return j;
+    return NULL;
+}
+
+// ============================================================================
+//                           RESOURCE ACCOUNTING
+// ----------------------------------------------------------------------------
+// Every finished job is folded into the session statistics (for `stats`) and,
+// with -l, appended to a JSON-lines log. Times are summed over the job's
+// processes; max RSS is the largest of them. A utility run inside the shell
+// is recorded the same way, from deltas of the shell's own usage.
+// ============================================================================
+typedef struct {
+    double user, sys;
+    long   maxrss_kb;
+    long   nvcsw, nivcsw;  // voluntary / involuntary context switches
+} usage_t;
+
+static struct {
+    unsigned long count;
+    double        total, min, max;
+    unsigned long hist[HIST_BUCKETS];
+} session;
+
+static FILE *json_log;
+
+static double tv_sec(const struct timeval *tv) {
+    return tv->tv_sec + tv->tv_usec / 1e6;
+}
+
+static usage_t job_usage(const job_t *j) {
+    usage_t u = {0};
+    for (size_t i = 0; i < j->n; i++) {
+        const struct rusage *ru = &j->procs[i].ru;
+        u.user   += tv_sec(&ru->ru_utime);
+        u.sys    += tv_sec(&ru->ru_stime);
+        u.nvcsw  += ru->ru_nvcsw;
+        u.nivcsw += ru->ru_nivcsw;
+        if (ru->ru_maxrss > u.maxrss_kb)
+            u.maxrss_kb = ru->ru_maxrss;
+    }
+    return u;
+}
+
+static void json_string(FILE *f, const char *s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\')
+            fprintf(f, "\\%c", c);
+        else if (c < 0x20)
+            fprintf(f, "\\u%04x", c);
+        else
+            fputc(c, f);
+    }
+    fputc('"', f);
+}
+
+static void account(const char *cmdline, int status, double wall,
+                    const usage_t *u) {
+    if (session.count == 0 || wall < session.min) session.min = wall;
+    if (session.count == 0 || wall > session.max) session.max = wall;
+    session.count++;
+    session.total += wall;
+
+    int b = 0;
+    for (double ms = wall * 1e3; ms >= 1.0 && b < HIST_BUCKETS - 1; ms /= 2)
+        b++;
+    session.hist[b]++;
+
+    if (json_log) {
+        fprintf(json_log, "{\"cmd\":");
+        json_string(json_log, cmdline);
+        fprintf(json_log,
+                ",\"status\":%d,\"wall\":%.6f,\"user\":%.6f,\"sys\":%.6f"
+                ",\"maxrss_kb\":%ld,\"nvcsw\":%ld,\"nivcsw\":%ld}\n",
+                status, wall, u->user, u->sys,
+                u->maxrss_kb, u->nvcsw, u->nivcsw);
+        fflush(json_log);
+    }
+}
+
+static void job_account(const job_t *j) {
+    usage_t u = job_usage(j);
+    account(j->cmdline, job_status(j), j->end - j->start, &u);
+}
+
+static void usage_report(double real, const usage_t *u) {
+    fprintf(stderr,
+            "\nreal\t%.3fs\nuser\t%.3fs\nsys\t%.3fs\n"
+            "maxrss\t%ld KB\nctxsw\t%ld voluntary, %ld involuntary\n",
+            real, u->user, u->sys,
+            u->maxrss_kb, u->nvcsw, u->nivcsw);
+}
+
+static void usage_print(const job_t *j) {
+    usage_t u = job_usage(j);
+    usage_report(j->end - j->start, &u);
+}
+
+// A utility run inside the shell: deltas of the shell's own usage since r0
+// (maxrss is the shell's, it only grows)
+static usage_t usage_self(const struct rusage *r0) {
+    struct rusage r1;
+    getrusage(RUSAGE_SELF, &r1);
+
+    usage_t u = {0};
+    u.user      = tv_sec(&r1.ru_utime) - tv_sec(&r0->ru_utime);
+    u.sys       = tv_sec(&r1.ru_stime) - tv_sec(&r0->ru_stime);
+    u.nvcsw     = r1.ru_nvcsw - r0->ru_nvcsw;
+    u.nivcsw    = r1.ru_nivcsw - r0->ru_nivcsw;
+    u.maxrss_kb = r1.ru_maxrss;
+    return u;
+}
+
+// Applies one exit status to whichever job owns pid.
+static void job_child_exited(pid_t pid, int status, const struct rusage *ru,
+                             double when) {
+    for (job_t *j = jobs; j; j = j->next) {
+        for (size_t i = 0; i < j->n; i++) {
+            proc_t *pr = &j->procs[i];
+            if (pr->pid != pid || pr->done)
+                continue;
+
+            pr->done   = 1;
+            pr->status = status;
+            pr->ru     = *ru;
+            if (--j->live == 0) {
+                j->end = when;
+                job_account(j);
+            }
+
+            // 127 from a cached path: drop the entry if the file disappeared
+            if (pr->cached && WIFEXITED(status) && WEXITSTATUS(status) == 127)
+                pcache_recheck(pr->name);
+            return;
+        }
+    }
+}
+
+// Call with SIGCHLD blocked. Drains the handler's ring, then sweeps for
+// anything it had no room for.
+static void reap_children(void) {
+    while (reap_tail != reap_head) {
+        int slot = reap_tail % REAP_RING;
+        job_child_exited(reap_ring[slot].pid, reap_ring[slot].status,
+                         &reap_ring[slot].ru, ts_sec(&reap_ring[slot].when));
+        reap_tail++;
+    }
+
+    int           st;
+    pid_t         pid;
+    struct rusage ru;
+    while ((pid = wait4(-1, &st, WNOHANG, &ru)) > 0)
+        job_child_exited(pid, st, &ru, now_sec());
+}
+
+// Blocks (SIGCHLD blocked on entry) until j has no live processes.
+static void job_wait(job_t *j) {
+    for (;;) {
+        reap_children();
+        if (j->live == 0)
+            return;
+        pool_idle();
+        sigsuspend(&shell_mask);
+    }
+}
+
+static void jobs_print(const job_t *j) {
+    if (j->live)
+        printf("[%d]  Running\t\t%s\n", j->id, j->cmdline);
+    else if (job_status(j) == 0)
+        printf("[%d]  Done\t\t%s\n", j->id, j->cmdline);
+    else
+        printf("[%d]  Exit %d\t\t%s\n", j->id, job_status(j), j->cmdline);
+}
+
+// Reports and forgets finished background jobs (before each prompt).
+static void jobs_notify(void) {
+    reap_children();
+
+    job_t *j = jobs;
+    while (j) {
+        job_t *next = j->next;
+        if (j->background && j->live == 0) {
+            jobs_print(j);
+            job_remove(j);
+        }
+        j = next;
+    }
+}
+
+// ============================================================================
+//                            PRE-FORKED POOL
+// ----------------------------------------------------------------------------
+// With -p N the shell keeps N idle children ("zygotes") forked ahead of
+// time. Each one blocks on its end of a SOCK_SEQPACKET socketpair. A launch
+// sends it one message: the stage's stdin/stdout/stderr as SCM_RIGHTS fds,
+// plus the resolved path, argv and redirection file names. The zygote dup2s
+// the fds into place and goes straight to exec_stage(), so the fork() was
+// paid earlier, off the critical path. A zygote is already our child, so
+// SIGCHLD reaping and the job table work unchanged.
+//
+// Refill policy:
+//   eager   fork a replacement right after each launch
+//   idle    only refill at idle points (before the prompt, while waiting)
+//
+// Zygotes inherit the shell's cwd and environment at fork time, so any
+// change to either must call pool_flush().
+// ============================================================================
+typedef struct {
     pid_t pid;
+    int   sock;            // shell's end, -1 when the slot is empty
+} zygote_t;
+
+static struct {
+    zygote_t *slots;
+    size_t    size;
+    int       eager;
+    // launch-latency bookkeeping (seconds)
+    unsigned long dispatches, forks;
+    double        dispatch_time, fork_time;
+} pool;
+
+// Message layout: int header[5] = { argc, append, has_path, has_in, has_out }
+// followed by NUL-terminated strings: [path] argv[0..argc-1] [in] [out].
+static void zygote_main(int sock) {
+    static char buf[POOL_MSG_MAX];
+    int         fds[3];
+    char        cbuf[CMSG_SPACE(sizeof(fds))];
+
+    struct iovec  iov = { buf, sizeof(buf) };
+    struct msghdr msg = {0};
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+
+    ssize_t n;
+    while ((n = recvmsg(sock, &msg, 0)) == -1 && errno == EINTR)
+        ;
+    if (n <= 0)
+        _exit(0);                         // shell went away or flushed us
+
+    struct cmsghdr *cm = CMSG_FIRSTHDR(&msg);
+    if (!cm || cm->cmsg_type != SCM_RIGHTS || (size_t)n < 5 * sizeof(int))
+        _exit(126);
+    memcpy(fds, CMSG_DATA(cm), sizeof(fds));
+    close(sock);
+
+    for (int k = 0; k < 3; k++) {
+        dup2(fds[k], k);
+    }
+    for (int k = 0; k < 3; k++)
+        if (fds[k] > STDERR_FILENO)
+            close(fds[k]);
+
+    int hdr[5];
+    memcpy(hdr, buf, sizeof(hdr));
+    char *str = buf + sizeof(hdr);
+    char *end = buf + n;
+
+    cmd_t c = {0};
+    c.append = hdr[1];
+    if (hdr[2]) { c.path = str; str += strlen(str) + 1; }
+    for (int k = 0; k < hdr[0] && str < end; k++) {
+        cmd_push_arg(&c, str);
+        str += strlen(str) + 1;
+    }
+    if (hdr[3]) { c.in_file  = str; str += strlen(str) + 1; }
+    if (hdr[4]) { c.out_file = str; }
+    if (c.argc == 0)
+        _exit(126);
+
+    exec_stage(&c, STDIN_FILENO, STDOUT_FILENO);
+}
+
+static void pool_spawn(size_t slot) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) == -1) {
+        perror("socketpair");
+        return;
+    }
+
+    fflush(stdout);            // the zygote's utilities flush what they inherit
+    fflush(stderr);
+    double t0  = now_sec();
+    pid_t  pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        close(sv[0]);
+        close(sv[1]);
+        return;
+    }
+    if (pid == 0) {
+        sigprocmask(SIG_SETMASK, &shell_mask, NULL);
+        // other zygotes must see EOF when the shell exits
+        for (size_t k = 0; k < pool.size; k++)
+            if (pool.slots[k].sock != -1)
+                close(pool.slots[k].sock);
+        close(sv[0]);
+        zygote_main(sv[1]);
+    }
+    pool.fork_time += now_sec() - t0;
+    pool.forks++;
+
+    close(sv[1]);
+    pool.slots[slot].pid  = pid;
+    pool.slots[slot].sock = sv[0];
+}
+
+static void pool_refill(void) {
+    for (size_t k = 0; k < pool.size; k++)
+        if (pool.slots[k].sock == -1)
+            pool_spawn(k);
+}
+
+// Closing a zygote's socket makes it exit; the reaper collects it later.
+static void pool_flush(void) {
+    for (size_t k = 0; k < pool.size; k++) {
+        if (pool.slots[k].sock != -1) {
+            close(pool.slots[k].sock);
+            pool.slots[k].sock = -1;
+        }
+    }
+}
+
+static void pool_init(size_t size, int eager) {
+    pool.slots = xrealloc(NULL, size * sizeof(*pool.slots));
+    pool.size  = size;
+    pool.eager = eager;
+    for (size_t k = 0; k < size; k++)
+        pool.slots[k].sock = -1;
+    pool_refill();
+}
+
+static void pool_put_str(char *buf, size_t *len, const char *s) {
+    size_t n = strlen(s) + 1;
+    if (*len + n <= POOL_MSG_MAX)
+        memcpy(buf + *len, s, n);
+    *len += n;
+}
+
+// Hands a stage to an idle zygote. Returns its pid, or -1 when the pool is
+// empty or the command does not fit (the caller then forks as usual).
+static pid_t pool_dispatch(const cmd_t *c, int in_fd, int out_fd, int err_fd) {
+    static char buf[POOL_MSG_MAX];
+
+    size_t k = 0;
+    while (k < pool.size && pool.slots[k].sock == -1)
+        k++;
+    if (k == pool.size)
+        return -1;
+
+    double t0 = now_sec();
+
+    int    hdr[5] = { (int)c->argc, c->append, c->path != NULL,
+                      c->in_file != NULL, c->out_file != NULL };
+    size_t len    = sizeof(hdr);
+    memcpy(buf, hdr, sizeof(hdr));
+    if (c->path)
+        pool_put_str(buf, &len, c->path);
+    for (size_t a = 0; a < c->argc; a++)
+        pool_put_str(buf, &len, c->argv[a]);
+    if (c->in_file)
+        pool_put_str(buf, &len, c->in_file);
+    if (c->out_file)
+        pool_put_str(buf, &len, c->out_file);
+    if (len > POOL_MSG_MAX)
+        return -1;
+
+    int  fds[3] = { in_fd, out_fd, err_fd };
+    char cbuf[CMSG_SPACE(sizeof(fds))];
+    memset(cbuf, 0, sizeof(cbuf));
+
+    struct iovec  iov = { buf, len };
+    struct msghdr msg = {0};
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+
+    struct cmsghdr *cm = CMSG_FIRSTHDR(&msg);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type  = SCM_RIGHTS;
+    cm->cmsg_len   = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cm), fds, sizeof(fds));
+
+    zygote_t *z  = &pool.slots[k];
+    ssize_t   rc = sendmsg(z->sock, &msg, MSG_NOSIGNAL);
+    close(z->sock);
+    z->sock = -1;
+    if (rc == -1)
+        return -1;                        // zygote died; fall back to fork
+
+    pool.dispatch_time += now_sec() - t0;
+    pool.dispatches++;
+    return z->pid;
+}
+
+// Called when the shell is about to wait or prompt.
+static void pool_idle(void) {
+    if (pool.size)
+        pool_refill();
+}
+
+// pool          launch counts and the fork latency the pool kept off the
+//               launch path (written to out)
+static int builtin_pool(FILE *out) {
+    if (pool.size == 0) {
+        fprintf(out, "pool disabled (start the shell with -p N)\n");
+        return 0;
+    }
+
+    size_t ready = 0;
+    for (size_t k = 0; k < pool.size; k++)
+        ready += pool.slots[k].sock != -1;
+
+    double fork_us = pool.forks ? 1e6 * pool.fork_time / pool.forks : 0.0;
+    double disp_us = pool.dispatches ? 1e6 * pool.dispatch_time / pool.dispatches : 0.0;
+
+    fprintf(out, "pool: %zu/%zu ready, refill %s\n", ready, pool.size,
+           pool.eager ? "eager" : "idle");
+    fprintf(out, "launches via pool: %lu (avg dispatch %.1f us)\n", pool.dispatches, disp_us);
+    fprintf(out, "forks (pool refill + fallback): %lu (avg %.1f us)\n", pool.forks, fork_us);
+    fprintf(out, "launch latency saved: ~%.3f ms\n",
+           pool.dispatches * (fork_us - disp_us) / 1e3);
+    return 0;
+}
+
+// ============================================================================
+//                              LAUNCH PIPELINE
+// ----------------------------------------------------------------------------
+// Forks every stage up front so they all run concurrently, connected by
+// pipes, and registers them as one job. Background jobs read /dev/null
+// instead of the terminal. With capture set, stdout of the last stage and
+// stderr of every stage go to a temp file (job->capture_fd) instead.
+// Stages go to a pre-forked zygote when one is ready.
+// Returns the job, or NULL if nothing was started.
+// ============================================================================
+static job_t *launch_job(pipeline_t *p, const char *cmdline, int capture) {
+    job_t *j = xrealloc(NULL, sizeof(*j));
+    memset(j, 0, sizeof(*j));
+    j->background = p->background;
+    j->capture_fd = -1;
+    j->cmdline    = strdup(cmdline);
+    j->procs      = xrealloc(NULL, p->n * sizeof(proc_t));
+    j->start      = now_sec();
+
+    if (capture) {
+        FILE *tmp = tmpfile();
+        if (tmp) {
+            j->capture_fd = dup(fileno(tmp));  // keep the fd, drop the FILE
+            fclose(tmp);
+            fcntl(j->capture_fd, F_SETFD, FD_CLOEXEC);
+        } else {
+            perror("tmpfile");
+        }
+    }
+
+    // resolve commands in the parent so the cache survives across launches
+    for (size_t i = 0; i < p->n; i++) {
+        cmd_t *c = &p->cmds[i];
+        c->path = (strchr(c->argv[0], '/') || is_util(c)) ? NULL
+                                                          : pcache_lookup(c->argv[0]);
+    }
+
+    int in_fd = STDIN_FILENO;
+    if (p->background) {
+        in_fd = open("/dev/null", O_RDONLY);
+        if (in_fd == -1)
+            in_fd = STDIN_FILENO;
+    }
+
+    for (size_t i = 0; i < p->n; i++) {
+        int fds[2] = { -1, STDOUT_FILENO };
+
+        if (i + 1 < p->n && pipe(fds) == -1) {
+            perror("pipe");
+            break;
+        }
+        if (i + 1 == p->n && j->capture_fd != -1)
+            fds[1] = j->capture_fd;
+
+        int   err_fd = j->capture_fd != -1 ? j->capture_fd : STDERR_FILENO;
+        pid_t pid    = pool_dispatch(&p->cmds[i], in_fd, fds[1], err_fd);
+
+        if (pid == -1) {
+            double t0 = now_sec();
+            fflush(stdout);    // or the child's utility re-prints our buffer
+            fflush(stderr);
+            pid = fork();
+            if (pid > 0) {
+                pool.fork_time += now_sec() - t0;
+                pool.forks++;
+            }
+        }
+        if (pid < 0) {
+            perror("fork");
+            if (i + 1 < p->n) { close(fds[0]); close(fds[1]); }
+            break;
+        }
+        if (pid == 0) {
+            sigprocmask(SIG_SETMASK, &shell_mask, NULL);
+            if (j->capture_fd != -1)
+                dup2(j->capture_fd, STDERR_FILENO);
+            if (i + 1 < p->n)
+                close(fds[0]); // next stage's read end is not ours
+            exec_stage(&p->cmds[i], in_fd, fds[1]);
+        }
+
+        proc_t *pr = &j->procs[j->n++];
+        pr->pid    = pid;
+        pr->name   = strdup(p->cmds[i].argv[0]);
+        pr->cached = p->cmds[i].path != NULL;
+        pr->done   = 0;
+        pr->status = 0;
+        memset(&pr->ru, 0, sizeof(pr->ru));
+        j->live++;
+
+        // parent: drop the ends the children now own
+        if (in_fd != STDIN_FILENO)
+            close(in_fd);
+        in_fd = STDIN_FILENO;
+        if (i + 1 < p->n) {
+            close(fds[1]);
+            in_fd = fds[0];
+        }
+    }
+    if (in_fd != STDIN_FILENO)
+        close(in_fd);
+
+    if (pool.size && pool.eager)
+        pool_refill();
+
+    if (j->n == 0) {
+        job_free(j);
+        return NULL;
+    }
+
+    // append with the next free id
+    job_t **pp = &jobs;
+    int     id = 1;
+    while (*pp) {
+        id = (*pp)->id + 1;
+        pp = &(*pp)->next;
+    }
+    j->id = id;
+    *pp   = j;
+    return j;
+}
+
+// ============================================================================
+//                                BUILTINS
+// ----------------------------------------------------------------------------
+// Run inside the shell process. Returns the builtin's exit status, or -1 when
+// argv[0] is not a builtin.
+// ============================================================================
+
+// jobs          list background jobs (finished ones are reported once)
+static int builtin_jobs(void) {
+    reap_children();
+
+    job_t *j = jobs;
+    while (j) {
+        job_t *next = j->next;
+        if (j->background) {
+            jobs_print(j);
+            if (j->live == 0)
+                job_remove(j);
+        }
+        j = next;
+    }
+    return 0;
+}
+
+// wait          wait for every background job
+// wait %N | N   wait for job N, return its exit status
+static int builtin_wait(const cmd_t *c) {
+    if (c->argc > 1) {
+        const char *arg = c->argv[1][0] == '%' ? c->argv[1] + 1 : c->argv[1];
+        job_t *j = job_find(atoi(arg));
+        if (!j || !j->background) {
+            fprintf(stderr, "wait: %s: no such job\n", c->argv[1]);
+            return 127;
+        }
+        job_wait(j);
+        int st = job_status(j);
+        job_remove(j);
+        return st;
+    }
+
+    for (job_t *j = jobs; j; j = j->next)
+        if (j->background)
+            job_wait(j);
+
+    job_t *j = jobs;
+    while (j) {
+        job_t *next = j->next;
+        if (j->background)
+            job_remove(j);
+        j = next;
+    }
+    return 0;
+}
+
+// stats         latency histogram of every command run this session
+static int builtin_stats(void) {
+    reap_children();
+
+    if (session.count == 0) {
+        printf("no commands run yet\n");
+        return 0;
+    }
+    printf("commands: %lu  total: %.3fs  mean: %.3fms  min: %.3fms  max: %.3fms\n",
+           session.count, session.total, 1e3 * session.total / session.count,
+           1e3 * session.min, 1e3 * session.max);
+
+    unsigned long peak = 0;
+    int           last = 0;
+    for (int b = 0; b < HIST_BUCKETS; b++) {
+        if (session.hist[b] > peak) peak = session.hist[b];
+        if (session.hist[b])        last = b;
+    }
+    for (int b = 0; b <= last; b++) {
+        double lo = b ? (double)(1UL << (b - 1)) : 0.0;
+        double hi = (double)(1UL << b);
+        int    bar = (int)(40 * session.hist[b] / peak);
+        printf("%8.0f - %-8.0f ms %6lu  ", lo, hi, session.hist[b]);
+        for (int k = 0; k < bar; k++)
+            putchar('#');
+        putchar('\n');
+    }
+    return 0;
+}
+
+// cd [dir]      change directory ($HOME by default)
+static int builtin_cd(const cmd_t *c) {
+    const char *dir = c->argc > 1 ? c->argv[1] : getenv("HOME");
+    if (!dir) {
+        fprintf(stderr, "cd: HOME not set\n");
+        return 1;
+    }
+    if (chdir(dir) == -1) {
+        fprintf(stderr, "cd: %s: %s\n", dir, strerror(errno));
+        return 1;
+    }
+
+    char *cwd = getcwd(NULL, 0);
+    if (cwd) {
+        const char *old = getenv("PWD");
+        if (old)
+            setenv("OLDPWD", old, 1);
+        setenv("PWD", cwd, 1);
+        free(cwd);
+    }
+    pcache_drop_relative();   // "." or "" on $PATH now means somewhere else
+    pool_flush();             // zygotes still sit in the old directory
+    return 0;
+}
+
+// Lone foreground utility: run it right here, around its redirections.
+static int run_util_in_shell(const pipeline_t *pl) {
+    const cmd_t *c = &pl->cmds[0];
+    if (pl->n != 1 || pl->background || !is_util(c))
+        return -1;
+
+    int saved[2];
+    if (redirect_shell(c, saved) == -1)
+        return 1;
+    int rc = run_util(c);
+    restore_shell(saved);
+    return rc;
+}
+
+static int run_builtin(const cmd_t *c) {
+    if (strcmp(c->argv[0], "cd") == 0)
+        return builtin_cd(c);
+    if (strcmp(c->argv[0], "hash") == 0)
+        return builtin_hash(c);
+    if (strcmp(c->argv[0], "jobs") == 0)
+        return builtin_jobs();
+    if (strcmp(c->argv[0], "wait") == 0)
+        return builtin_wait(c);
+    if (strcmp(c->argv[0], "stats") == 0)
+        return builtin_stats();
+    if (strcmp(c->argv[0], "pool") == 0)
+        return builtin_pool(stdout);
+    return -1;
+}
+
+// ============================================================================
+//                               LINE PARSING
+// ----------------------------------------------------------------------------
+// Tokenizes and parses one input line. Returns 1 when pl holds a command to
+// run, 0 for blank lines and syntax errors. The caller frees toks and pl.
+// ============================================================================
+static int parse_line(const char *line, tokens_t *toks, pipeline_t *pl) {
+    return tokenize(line, toks) == 0 && parse(toks, pl) == 0 && pl->n > 0;
+}
+
+static int is_exit(const pipeline_t *pl) {
+    return pl->n == 1 && strcmp(pl->cmds[0].argv[0], "exit") == 0;
+}
+
+// `time cmd ...` is a prefix, not a command: strip it and report whether
+// it was there.
+static int strip_time(pipeline_t *pl) {
+    cmd_t *c = &pl->cmds[0];
+    if (strcmp(c->argv[0], "time") != 0 || c->argc < 2)
+        return 0;
+    memmove(c->argv, c->argv + 1, c->argc * sizeof(*c->argv)); // incl. NULL
+    c->argc--;
+    return 1;
+}
+
+// ============================================================================
+//                               BATCH MODE
+// ----------------------------------------------------------------------------
+// xargs -P style: reads one command per line from stdin and keeps up to
+// `slots` of them running, starting the next one as soon as any finishes.
+// Commands read /dev/null. With `group`, each command's output is held in a
+// temp file and written out in one piece when it finishes, so outputs of
+// concurrent commands never interleave.
+//
+// `wait` waits for every command started so far (a barrier between the lines
+// before and after it); `jobs` retires whatever has finished and lists the
+// rest. Both go through the same finish path as any other completion, so the
+// slot count stays right.
+//
+// Prints a summary to stderr: failed commands with their exit codes, total
+// wall time and the sum of per-command wall times. Returns 0 when every
+// command exited 0, otherwise 1.
+// ============================================================================
+typedef struct {
+    long   launched, finished, failed;
+    double busy;               // sum of per-command wall times
+} batch_stats_t;
+
+static void batch_finish(job_t *j, int group, batch_stats_t *bs) {
+    int st = job_status(j);
+
+    bs->finished++;
+    bs->busy += j->end - j->start;
+    if (st != 0) {
+        bs->failed++;
+        fprintf(stderr, "[%ld] exit %d: %s\n", j->seq, st, j->cmdline);
+    }
+
+    if (group && j->capture_fd != -1) {
+        char    buf[4096];
+        ssize_t n;
+        fflush(stdout);
+        lseek(j->capture_fd, 0, SEEK_SET);
+        while ((n = read(j->capture_fd, buf, sizeof(buf))) > 0)
+            if (write(STDOUT_FILENO, buf, (size_t)n) != n)
+                break;
+    }
+    job_remove(j);
+}
+
+// Retires every finished job (SIGCHLD blocked). Returns how many.
+static long batch_retire(int group, batch_stats_t *bs) {
+    reap_children();
+
+    long   retired = 0;
+    job_t *j       = jobs;
+    while (j) {
+        job_t *next = j->next;
+        if (j->live == 0) {
+            batch_finish(j, group, bs);
+            retired++;
+        }
+        j = next;
+    }
+    return retired;
+}
+
+// Waits (SIGCHLD blocked) until at least one running job finishes and
+// retires every finished one. Returns how many were retired.
+static long batch_wait_any(int group, batch_stats_t *bs) {
+    for (;;) {
+        long retired = batch_retire(group, bs);
+        if (retired)
+            return retired;
+        pool_idle();
+        sigsuspend(&shell_mask);
+    }
+}
+
+// `wait` and `jobs` in batch mode; -1 for anything else
+static int batch_builtin(const cmd_t *c, long *running, int group, batch_stats_t *bs) {
+    if (strcmp(c->argv[0], "wait") == 0) {
+        while (*running > 0)
+            *running -= batch_wait_any(group, bs);
+        return 0;
+    }
+    if (strcmp(c->argv[0], "jobs") == 0) {
+        *running -= batch_retire(group, bs);
+        for (job_t *j = jobs; j; j = j->next)
+            jobs_print(j);
+        fflush(stdout);
+        return 0;
+    }
+    return -1;
+}
+
+static int batch_loop(long slots, int group) {
+    char         *line = NULL;
+    size_t        cap  = 0;
+    long          seq  = 0, running = 0;
+    batch_stats_t bs   = {0};
+    double        t0   = now_sec();
+
+    while (getline(&line, &cap, stdin) != -1) {
+        seq++;
+        line[strcspn(line, "\n")] = '\0';
+
+        tokens_t   toks = {0};
+        pipeline_t pl   = {0};
+
+        if (parse_line(line, &toks, &pl)) {
+            if (is_exit(&pl)) {
+                pipeline_free(&pl);
+                tokens_free(&toks);
+                break;
+            }
+            if (pl.n > 1 || (batch_builtin(&pl.cmds[0], &running, group, &bs) == -1 &&
+                             run_builtin(&pl.cmds[0]) == -1)) {
+                while (running >= slots)
+                    running -= batch_wait_any(group, &bs);
+
+                pl.background = 1;            // never read our stdin
+                job_t *j = launch_job(&pl, line, group);
+                if (j) {
+                    j->seq = seq;
+                    bs.launched++;
+                    running++;
+                }
+            }
+        }
+
+        pipeline_free(&pl);
+        tokens_free(&toks);
+    }
+
+    while (running > 0)
+        running -= batch_wait_any(group, &bs);
+
+    double wall = now_sec() - t0;
+    fprintf(stderr,
+            "batch: %ld commands, %ld failed, %ld slots\n"
+            "batch: wall %.3fs, sum of command times %.3fs (%.2fx)\n",
+            bs.finished, bs.failed, slots,
+            wall, bs.busy, wall > 0 ? bs.busy / wall : 0.0);
+    if (pool.size)
+        builtin_pool(stderr);
+
+    free(line);
+    return bs.failed ? 1 : 0;
+}
+
+// ============================================================================
+//                             INTERACTIVE MODE
+// ============================================================================
+static void interactive_loop(void) {
+
+    char   *line = NULL;
+    size_t  cap  = 0;
 
     // infinite loop
-    while (1){
-	
-	// OUTPUT
-	printf("cmd> ");
-	fflush(stdout);
-	
-	// INPUT  
-	if (fgets(input, sizeof(input), stdin) == NULL){
-	   break;
-	}
-	input[strcspn(input, "\n")] = '\0'; // strip whitespace
-	
-	// exit parent process on "exit" 
-	if (strcmp(input, "exit") == 0){
-	    break;
-	}
-	
-	// create child process
-	pid = fork(); 
-	
-	// fork() error check
-	if (pid < 0){
-
-	    perror("fork");
-	    exit(-1); // return value indicates failure
-	}
-	else if (pid == 0){
-	    execlp(input, input, (char*)NULL); 
-	    perror("execlp");
-	    _exit(-1);
-	 
-	 // execcvp() // multiple args
-	 // execlp();
-	} 
-	else {
-
-	    // wait() error check
-	    if (wait(NULL) == -1) {
-		perror("wait");
-		exit(-1);
-	    }
-	}
+    while (1) {
+
+        jobs_notify();
+        pool_idle();
+
+        // OUTPUT
+        printf(PROMPT);
+        fflush(stdout);
+
+        // INPUT (any length); children may be reaped meanwhile
+        sigprocmask(SIG_UNBLOCK, &sigchld_only, NULL);
+        ssize_t len = getline(&line, &cap, stdin);
+        sigprocmask(SIG_BLOCK, &sigchld_only, NULL);
+        if (len == -1)
+            break;
+        line[strcspn(line, "\n")] = '\0';
+
+        tokens_t   toks = {0};
+        pipeline_t pl   = {0};
+
+        if (parse_line(line, &toks, &pl)) {
+
+            // exit parent process on "exit"
+            if (is_exit(&pl)) {
+                pipeline_free(&pl);
+                tokens_free(&toks);
+                break;
+            }
+
+            int           timed = strip_time(&pl);
+            double        t0    = now_sec();
+            struct rusage r0;
+            getrusage(RUSAGE_SELF, &r0);
+
+            int rc = run_util_in_shell(&pl);
+            if (rc != -1) {
+                // done without a fork; account for it like a reaped job
+                double  wall = now_sec() - t0;
+                usage_t u    = usage_self(&r0);
+                account(line, rc, wall, &u);
+                if (timed)
+                    usage_report(wall, &u);
+            } else if (pl.n > 1 || run_builtin(&pl.cmds[0]) == -1) {
+                job_t *j = launch_job(&pl, line, 0);
+                if (j && j->background) {
+                    printf("[%d] %d\n", j->id, (int)j->procs[j->n - 1].pid);
+                } else if (j) {
+                    job_wait(j);
+                    if (timed)
+                        usage_print(j);
+                    job_remove(j);
+                }
+            }
+        }
+
+        pipeline_free(&pl);
+        tokens_free(&toks);
 
     } // END - infinite loop
 
-    return 0;
+    free(line);
 }
 
+// ============================================================================
+//                                    MAIN
+// ============================================================================
+int main(int argc, char **argv) {
+
+    long slots = 0;   // 0 = interactive
+    int  group = 0;
+    long zygotes = 0;
+    int  eager = 1;
+    int  opt;
+
+    while ((opt = getopt(argc, argv, "j:gl:p:r:E")) != -1) {
+        switch (opt) {
+        case 'j':
+            slots = atol(optarg);
+            if (slots < 1) {
+                fprintf(stderr, "shell: -j needs a positive count\n");
+                return 2;
+            }
+            break;
+        case 'g':
+            group = 1;
+            break;
+        case 'l':
+            json_log = fopen(optarg, "a");
+            if (!json_log) {
+                perror(optarg);
+                return 2;
+            }
+            break;
+        case 'p':
+            zygotes = atol(optarg);
+            if (zygotes < 1) {
+                fprintf(stderr, "shell: -p needs a positive count\n");
+                return 2;
+            }
+            break;
+        case 'E':
+            no_utils = 1;
+            break;
+        case 'r':
+            if (strcmp(optarg, "eager") == 0) {
+                eager = 1;
+            } else if (strcmp(optarg, "idle") == 0) {
+                eager = 0;
+            } else {
+                fprintf(stderr, "shell: -r takes eager or idle\n");
+                return 2;
+            }
+            break;
+        default:
+            fprintf(stderr,
+                    "usage: %s [-j N [-g]] [-l log.jsonl] [-p N [-r eager|idle]] [-E]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    // SIGCHLD reaps asynchronously; keep it blocked outside of waits
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = sigchld_handler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+    if (sigaction(SIGCHLD, &sa, NULL) == -1) {
+        perror("sigaction");
+        exit(-1);
+    }
+    sigemptyset(&sigchld_only);
+    sigaddset(&sigchld_only, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &sigchld_only, &shell_mask);
+    sigdelset(&shell_mask, SIGCHLD);
+
+    if (zygotes > 0)
+        pool_init((size_t)zygotes, eager);
+
+    int rc = 0;
+    if (slots > 0)
+        rc = batch_loop(slots, group);
+    else
+        interactive_loop();
+
+    pool_flush();
+    free(pool.slots);
+    while (jobs)
+        job_remove(jobs);
+    if (json_log)
+        fclose(json_log);
+    pcache_clear();
+    free(pcache.path_env);
+    return rc;
+}
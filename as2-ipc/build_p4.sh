@@ -0,0 +1,5 @@
+#!/usr/bin/env bash
+
+gcc -Wall -Wextra -O2 -std=c17 shm_handoff.c -lrt -o shm_handoff
+ln -sf shm_handoff shm_recv
+ln -sf shm_handoff shm_send
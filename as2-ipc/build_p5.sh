@@ -0,0 +1,6 @@
+#!/usr/bin/env bash
+
+gcc -Wall -Wextra -O2 -std=c17 shm_ring_queue.c -lrt -o shm_ring_queue
+ln -sf shm_ring_queue ring_recv
+ln -sf shm_ring_queue ring_send
+gcc -Wall -Wextra -O2 -std=c17 ipc_bench.c -lrt -o ipc_bench
@@ -0,0 +1,226 @@
+// ipc_bench.c
+//
+// Message throughput between two processes: POSIX mqueue vs pipe vs the
+// shared-memory ring (../common/shm_ring.h).
+// ----------------------------------------------------------------------------
+// Build:
+//   ./build_p5.sh
+//
+// Run:
+//   ./ipc_bench [-n messages]
+//
+// The parent sends n messages of each size, the forked child receives them
+// and checks their length and first byte. Prints messages/s and MB/s.
+//   mqueue   mq_send / mq_receive, queue depth MQ_DEPTH (the default limit
+//            for unprivileged users is 10)
+//   pipe     one write() / read() per message
+//   ring     shm_ring_send / shm_ring_recv, RING_BYTES of buffer
+
+#define _GNU_SOURCE   // syscall() for the futex wrappers
+
+#include <errno.h>
+#include <fcntl.h>
+#include <mqueue.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../common/shm_ring.h"
+
+// ============================================================================
+//                                CONFIGURATION
+// ============================================================================
+#define MQ_NAME       "/cpsc351bench"
+#define MQ_DEPTH      10
+#define RING_BYTES    65536
+#define MAX_MSG       4096
+#define DEFAULT_MSGS  200000L
+
+typedef enum { T_MQ, T_PIPE, T_RING } transport_t;
+
+static const char *names[] = { "mqueue", "pipe", "ring" };
+
+// ============================================================================
+//                                 TRANSPORTS
+// ----------------------------------------------------------------------------
+// Set up before fork(), so both processes share them.
+// ============================================================================
+typedef struct {
+    transport_t t;
+    mqd_t       mq;
+    int         pipefd[2];
+    shm_ring   *ring;
+    size_t      ring_bytes;
+} chan_t;
+
+static int chan_open(chan_t *c, transport_t t, size_t msg) {
+    c->t = t;
+    switch (t) {
+    case T_MQ: {
+        struct mq_attr attr = { .mq_maxmsg = MQ_DEPTH, .mq_msgsize = (long)msg };
+        mq_unlink(MQ_NAME);
+        c->mq = mq_open(MQ_NAME, O_CREAT | O_RDWR, 0600, &attr);
+        if (c->mq == (mqd_t)-1) {
+            perror("mq_open");
+            return -1;
+        }
+        mq_unlink(MQ_NAME);   // the descriptor survives fork()
+        return 0;
+    }
+    case T_PIPE:
+        if (pipe(c->pipefd) == -1) {
+            perror("pipe");
+            return -1;
+        }
+        return 0;
+    case T_RING:
+        // anonymous shared mapping: same memory as a shm_open() segment
+        c->ring_bytes = shm_ring_bytes(RING_BYTES);
+        c->ring = mmap(NULL, c->ring_bytes, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (c->ring == MAP_FAILED) {
+            perror("mmap");
+            return -1;
+        }
+        shm_ring_init(c->ring, RING_BYTES);
+        return 0;
+    }
+    return -1;
+}
+
+static void chan_close(chan_t *c) {
+    switch (c->t) {
+    case T_MQ:   mq_close(c->mq);                   break;
+    case T_PIPE: close(c->pipefd[0]);
+                 close(c->pipefd[1]);               break;
+    case T_RING: munmap(c->ring, c->ring_bytes);    break;
+    }
+}
+
+static int chan_send(chan_t *c, const char *buf, size_t n) {
+    switch (c->t) {
+    case T_MQ:   return mq_send(c->mq, buf, n, 0);
+    case T_PIPE: return write(c->pipefd[1], buf, n) == (ssize_t)n ? 0 : -1;
+    case T_RING: return shm_ring_send(c->ring, buf, n);
+    }
+    return -1;
+}
+
+static ssize_t chan_recv(chan_t *c, char *buf, size_t n) {
+    switch (c->t) {
+    case T_MQ:   return mq_receive(c->mq, buf, MAX_MSG, NULL);
+    case T_PIPE: {
+        size_t got = 0;   // a pipe is a byte stream: read the whole message
+        while (got < n) {
+            ssize_t r = read(c->pipefd[0], buf + got, n - got);
+            if (r <= 0)
+                return -1;
+            got += (size_t)r;
+        }
+        return (ssize_t)got;
+    }
+    case T_RING: return shm_ring_recv(c->ring, buf, MAX_MSG);
+    }
+    return -1;
+}
+
+// ============================================================================
+//                                  ONE RUN
+// ----------------------------------------------------------------------------
+// Returns messages per second, or -1 on failure.
+// ============================================================================
+static double run(transport_t t, size_t msg, long count) {
+    chan_t c;
+    if (chan_open(&c, t, msg) == -1)
+        return -1;
+
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("fork");
+        chan_close(&c);
+        return -1;
+    }
+
+    static char buf[MAX_MSG];
+    if (pid == 0) {
+        // receiver
+        int bad = 0;
+        for (long i = 0; i < count; i++) {
+            ssize_t n = chan_recv(&c, buf, msg);
+            if (n != (ssize_t)msg || buf[0] != (char)i)
+                bad = 1;
+        }
+        _exit(bad);
+    }
+
+    long long t0 = now_ns();
+    for (long i = 0; i < count; i++) {
+        buf[0] = (char)i;
+        if (chan_send(&c, buf, msg) == -1) {
+            // the receiver still waits for the rest: don't wait for it
+            perror(names[t]);
+            kill(pid, SIGKILL);
+            waitpid(pid, NULL, 0);
+            chan_close(&c);
+            return -1;
+        }
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    double secs = (now_ns() - t0) / 1e9;
+
+    chan_close(&c);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "%s: receiver saw corrupted or missing messages\n", names[t]);
+        return -1;
+    }
+    return count / secs;
+}
+
+// ============================================================================
+//                                     MAIN
+// ============================================================================
+int main(int argc, char *argv[]) {
+    long count = DEFAULT_MSGS;
+    int  opt;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+        case 'n': count = atol(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [-n messages]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (count < 1) {
+        fprintf(stderr, "bad -n\n");
+        return 1;
+    }
+
+    static const size_t sizes[] = { 64, 1024, MAX_MSG };
+
+    printf("%ld messages per point (Kmsg/s, MB/s)\n\n", count);
+    printf("%8s", "bytes");
+    for (int t = T_MQ; t <= T_RING; t++)
+        printf(" %10s %8s", names[t], "MB/s");
+    printf("\n");
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        printf("%8zu", sizes[s]);
+        for (int t = T_MQ; t <= T_RING; t++) {
+            double rate = run((transport_t)t, sizes[s], count);
+            if (rate < 0)
+                printf(" %10s %8s", "-", "-");
+            else
+                printf(" %10.1f %8.1f", rate / 1e3, rate * sizes[s] / 1e6);
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+    return 0;
+}
@@ -14,6 +14,9 @@
 //     Receiver blocks while waiting on notification. 
 //     Reveiver exits on a 0-byte message.
 //     Receiver unlinks the queue at before open & after close. 
+//
+// Same protocol over a shared-memory ring (no syscall per message):
+//     shm_ring_queue.c  (./ring_recv, ./ring_send; ./ipc_bench compares them)
 
 #include <errno.h>
 #include <fcntl.h>
@@ -0,0 +1,327 @@
+// shm_handoff.c
+//
+// CPSC 351 - Assignment 2 follow-up: Shared Memory + Process-Shared Semaphores
+// ----------------------------------------------------------------------------
+// Build:
+//   ./build_p4.sh
+//
+// Run (two terminals):
+//   ./shm_recv
+//   ./shm_send file.txt
+//
+// Notes:
+//   Part I (sender.c / recv.c) copies the whole file into shared memory and
+//   then pokes the receiver with kill(SIGUSR1), so nothing moves until the
+//   sender is done and the receiver does all its work in a signal handler.
+//
+//   Here the segment holds a ring of chunk buffers guarded by two
+//   process-shared semaphores (../common/shm_sem.h) living in the segment
+//   itself:
+//       empty   free slots      sender waits, receiver posts
+//       full    filled slots    receiver waits, sender posts
+//   Sender and receiver run concurrently; a handoff is a futex wake only
+//   when the other side is actually asleep. No signals; the receiver's PID
+//   is only used to tell whether it is still running.
+//
+//   A third semaphore, sender_lock, admits one sender at a time. The receiver
+//   serves one transfer after another until it can take sender_lock itself,
+//   i.e. no sender holds or is about to get it; then it marks the segment
+//   closed and exits. Senders wait with a timeout and give up once the
+//   segment is closed or the receiver is gone.
+//
+//   sender_lock tracks its holder, so if a sender crashes the next one is
+//   told (EOWNERDEAD) instead of hanging. A crash mid-transfer leaves the
+//   ring half-written: the receiver notices the dead sender by its pid and
+//   closes the segment, and the next sender aborts rather than write into
+//   it. Restart ./shm_recv to go on.
+
+#define _GNU_SOURCE   // syscall() for the futex wrappers
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../common/shm_sem.h"
+
+// ============================================================================
+//                                CONFIGURATION
+// ============================================================================
+#define SHM_NAME   "/cpsc351handoff"   // leading '/' required
+#define CHUNK      4096                // bytes per slot
+#define NSLOTS     16                  // ring size
+#define SEG_MAGIC  0x351351            // set once the receiver has initialised,
+                                       // cleared when it stops serving
+#define POLL_MS    200                 // how often each side checks the other
+
+typedef struct {
+    int  len;            // 0 = end of transfer
+    char data[CHUNK];
+} slot_t;
+
+typedef struct {
+    atomic_int    magic;
+    atomic_int    receiver_pid;
+    atomic_int    sender_pid;          // current sender, 0 = none
+    shm_semaphore sender_lock;         // one sender at a time (robust)
+    shm_semaphore empty;               // free slots
+    shm_semaphore full;                // filled slots
+    size_t        in;                  // next slot to fill  (sender only)
+    size_t        out;                 // next slot to drain (receiver only)
+    slot_t        slots[NSLOTS];
+} segment_t;
+
+// ============================================================================
+//                            RECEIVER (./shm_recv)
+// ----------------------------------------------------------------------------
+// 1. Create the segment, initialise the semaphores, publish SEG_MAGIC.
+// 2. Loop: wait on `full`, write the slot to file_recv, post `empty`.
+//    - 0-byte slot: end of one transfer. Once sender_lock can be taken,
+//      nobody else is sending: done. Otherwise serve the next sender, whose
+//      data is appended.
+//    - sender died: report and give up.
+// 3. Clear SEG_MAGIC and unlink the segment.
+// ============================================================================
+static int run_receiver(void) {
+    shm_unlink(SHM_NAME);   // dump any stale segment
+
+    int fd = shm_open(SHM_NAME, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd == -1) {
+        perror("shm_open (receiver)");
+        return 1;
+    }
+    if (ftruncate(fd, sizeof(segment_t)) == -1) {
+        perror("ftruncate");
+        close(fd);
+        shm_unlink(SHM_NAME);
+        return 1;
+    }
+    segment_t *seg = mmap(NULL, sizeof(segment_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (seg == MAP_FAILED) {
+        perror("mmap");
+        shm_unlink(SHM_NAME);
+        return 1;
+    }
+
+    shm_sem_init(&seg->sender_lock, 1);
+    shm_sem_init(&seg->empty, NSLOTS);
+    shm_sem_init(&seg->full, 0);
+    atomic_store(&seg->receiver_pid, (int)getpid());
+    atomic_store(&seg->sender_pid, 0);
+    seg->in  = 0;
+    seg->out = 0;
+    atomic_store(&seg->magic, SEG_MAGIC);
+
+    FILE *fp = fopen("file_recv", "wb");
+    if (!fp) {
+        perror("fopen(file_recv)");
+        munmap(seg, sizeof(segment_t));
+        shm_unlink(SHM_NAME);
+        return 1;
+    }
+
+    printf("Receiver ready on %s ...\n", SHM_NAME);
+
+    int    rc        = 0;
+    int    between   = 0;   // no transfer in progress, and one has ended
+    int    transfers = 0;
+    size_t total     = 0;
+    for (;;) {
+        // Between transfers: if nobody is queued on sender_lock and it is free
+        // (or its holder died after finishing), no sender is left; keep it so
+        // that none can start
+        if (between) {
+            if (atomic_load(&seg->sender_lock.waiters) == 0 &&
+                shm_sem_timedwait(&seg->sender_lock, POLL_MS) != ETIMEDOUT)
+                break;
+            between = 0;
+        }
+
+        if (shm_sem_wait_event(&seg->full, POLL_MS) == ETIMEDOUT) {
+            int pid = atomic_load(&seg->sender_pid);
+            if (pid > 0 && kill(pid, 0) == -1 && errno == ESRCH) {
+                fprintf(stderr, "Receiver: sender %d died mid-transfer\n", pid);
+                rc = 1;
+                break;
+            }
+            if (pid == 0 && transfers > 0)
+                between = 1;   // look at sender_lock again
+            continue;
+        }
+
+        slot_t *s = &seg->slots[seg->out++ % NSLOTS];
+        int     n = s->len;
+        if (n > 0 && fwrite(s->data, 1, (size_t)n, fp) != (size_t)n) {
+            perror("fwrite(file_recv)");
+            rc = 1;
+        }
+        shm_sem_post(&seg->empty);
+
+        if (rc)
+            break;
+        if (n == 0) {
+            printf("Receiver: %zu bytes received.\n", total);
+            total = 0;
+            transfers++;
+            between = 1;
+            continue;
+        }
+        total += (size_t)n;
+    }
+
+    atomic_store(&seg->magic, 0);   // senders still waiting give up
+    if (rc == 0)
+        printf("Receiver: no more senders. Closing.\n");
+
+    fclose(fp);
+    munmap(seg, sizeof(segment_t));
+    shm_unlink(SHM_NAME);
+    return rc;
+}
+
+// ============================================================================
+//                         SENDER (./shm_send <file>)
+// ----------------------------------------------------------------------------
+// 1. Open the existing segment (start ./shm_recv first).
+// 2. Take sender_lock; abort if the previous sender died mid-transfer.
+// 3. Loop: wait on `empty`, read up to CHUNK bytes into the slot, post `full`.
+// 4. Send a 0-byte slot, release sender_lock.
+// Every wait is timed and gives up once the receiver stops serving.
+// ============================================================================
+static int receiver_serving(segment_t *seg) {
+    if (atomic_load(&seg->magic) != SEG_MAGIC)
+        return 0;
+    int pid = atomic_load(&seg->receiver_pid);
+    return !(kill(pid, 0) == -1 && errno == ESRCH);
+}
+
+// Takes sender_lock. Returns 0, or -1 if this transfer can't go ahead.
+static int sender_lock_take(segment_t *seg) {
+    int rc;
+    while ((rc = shm_sem_timedwait(&seg->sender_lock, POLL_MS)) == ETIMEDOUT) {
+        if (!receiver_serving(seg)) {
+            fprintf(stderr, "Sender: the receiver has stopped serving\n");
+            return -1;
+        }
+    }
+
+    // A sender that died after its terminator clears sender_pid first, so a
+    // set pid means the ring is half-written and the receiver gives up on it
+    if (rc == EOWNERDEAD && atomic_load(&seg->sender_pid) != 0) {
+        fprintf(stderr, "Sender: previous sender died mid-transfer; restart ./shm_recv\n");
+        atomic_store(&seg->magic, 0);
+        shm_sem_post(&seg->sender_lock);
+        return -1;
+    }
+    if (!receiver_serving(seg)) {
+        fprintf(stderr, "Sender: the receiver has stopped serving\n");
+        shm_sem_post(&seg->sender_lock);
+        return -1;
+    }
+    return 0;
+}
+
+static int run_sender(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: ./shm_send <file>\n");
+        return 1;
+    }
+
+    FILE *fp = fopen(argv[1], "rb");
+    if (!fp) {
+        perror("fopen(input)");
+        return 1;
+    }
+
+    int fd = shm_open(SHM_NAME, O_RDWR, 0);
+    if (fd == -1) {
+        perror("shm_open (sender) - start ./shm_recv first");
+        fclose(fp);
+        return 1;
+    }
+    segment_t *seg = mmap(NULL, sizeof(segment_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (seg == MAP_FAILED) {
+        perror("mmap");
+        fclose(fp);
+        return 1;
+    }
+    if (atomic_load(&seg->magic) != SEG_MAGIC) {
+        fprintf(stderr, "Sender: receiver has not initialised the segment yet\n");
+        munmap(seg, sizeof(segment_t));
+        fclose(fp);
+        return 1;
+    }
+
+    if (sender_lock_take(seg) == -1) {
+        munmap(seg, sizeof(segment_t));
+        fclose(fp);
+        return 1;
+    }
+    atomic_store(&seg->sender_pid, (int)getpid());
+
+    printf("Sender ready. Sending '%s' in chunks up to %d bytes ...\n", argv[1], CHUNK);
+
+    int rc = 0;
+    for (;;) {
+        if (shm_sem_wait_event(&seg->empty, POLL_MS) == ETIMEDOUT) {
+            if (!receiver_serving(seg)) {
+                fprintf(stderr, "Sender: the receiver has stopped serving\n");
+                rc = 1;
+                break;
+            }
+            continue;
+        }
+        slot_t *s = &seg->slots[seg->in++ % NSLOTS];
+
+        size_t n = fread(s->data, 1, CHUNK, fp);
+        if (n == 0 && ferror(fp))
+            perror("fread");
+        s->len = (int)n;
+        shm_sem_post(&seg->full);
+
+        if (n == 0)
+            break;   // that was the terminator
+    }
+
+    atomic_store(&seg->sender_pid, 0);
+    shm_sem_post(&seg->sender_lock);
+
+    fclose(fp);
+    munmap(seg, sizeof(segment_t));
+    if (rc == 0)
+        printf("Sender done.\n");
+    return rc;
+}
+
+// ============================================================================
+//                                     MAIN
+// ----------------------------------------------------------------------------
+// Dispatch on argv[0], like msg_queue.c: ./shm_recv and ./shm_send are both
+// symlinks to shm_handoff (see build_p4.sh).
+// ============================================================================
+static const char *basename_ptr(const char *p) {
+    const char *slash = strrchr(p, '/');
+    return slash ? (slash + 1) : p;
+}
+
+int main(int argc, char **argv) {
+    const char *who = basename_ptr(argv[0]);
+
+    if (strcmp(who, "shm_recv") == 0)
+        return run_receiver();
+    if (strcmp(who, "shm_send") == 0)
+        return run_sender(argc, argv);
+
+    fprintf(stderr,
+            "Usage:\n"
+            "  ./shm_recv            (create segment, write chunks to file_recv)\n"
+            "  ./shm_send <file>     (stream <file> through the segment)\n");
+    return 1;
+}
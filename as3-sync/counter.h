@@ -0,0 +1,176 @@
+// counter.h
+//
+// CPSC 351 - Assignment 3 (Part I follow-up: Scalable Counters)
+// -------------------------------------------------------------------------------
+// Header-only counter library. p1_b.c has every thread fight over one mutex;
+// these are the alternatives from OSTEP ch. 29 and the usual lock-free ones.
+//
+//   mutex_counter_t    one pthread_mutex_t around one long (p1_b.c)
+//   atomic_counter_t   one atomic fetch-add; no lock, but one contended line
+//   sharded_counter_t  one cache-line padded slot per thread, summed on read
+//   batched_counter_t  thread-local count, flushed to a global every THRESHOLD
+//                      increments (OSTEP's "approximate counter")
+//
+// Sharded and batched counters take a thread index, unique per thread and in
+// 0..nthreads-1, so each thread touches only its own cache line on the fast
+// path. Two threads must never share an index.
+// -------------------------------------------------------------------------------
+
+#ifndef COUNTER_H
+#define COUNTER_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "../common/bench.h"
+
+// ============================================================================
+//                              MUTEX COUNTER
+// ============================================================================
+typedef struct {
+    pthread_mutex_t lock;
+    long            value;
+} mutex_counter_t;
+
+static inline void mutex_counter_init(mutex_counter_t *c) {
+    pthread_mutex_init(&c->lock, NULL);
+    c->value = 0;
+}
+
+static inline void mutex_counter_inc(mutex_counter_t *c) {
+    pthread_mutex_lock(&c->lock);
+    c->value++;
+    pthread_mutex_unlock(&c->lock);
+}
+
+static inline long mutex_counter_get(mutex_counter_t *c) {
+    pthread_mutex_lock(&c->lock);
+    long v = c->value;
+    pthread_mutex_unlock(&c->lock);
+    return v;
+}
+
+static inline void mutex_counter_destroy(mutex_counter_t *c) {
+    pthread_mutex_destroy(&c->lock);
+}
+
+// ============================================================================
+//                              ATOMIC COUNTER
+// ============================================================================
+typedef struct {
+    atomic_long value;
+} atomic_counter_t;
+
+static inline void atomic_counter_init(atomic_counter_t *c) {
+    atomic_init(&c->value, 0);
+}
+
+static inline void atomic_counter_inc(atomic_counter_t *c) {
+    atomic_fetch_add_explicit(&c->value, 1, memory_order_relaxed);
+}
+
+static inline long atomic_counter_get(atomic_counter_t *c) {
+    return atomic_load_explicit(&c->value, memory_order_relaxed);
+}
+
+// ============================================================================
+//                              SHARDED COUNTER
+// ----------------------------------------------------------------------------
+// Exact: a read sums every shard. Each shard owns a full cache line, so
+// increments from different threads never invalidate each other.
+// ============================================================================
+typedef struct {
+    CACHE_ALIGNED atomic_long value;
+} counter_shard_t;
+
+typedef struct {
+    counter_shard_t *shards;
+    int              nshards;
+} sharded_counter_t;
+
+// Returns 0, or -1 if the shards cannot be allocated.
+static inline int sharded_counter_init(sharded_counter_t *c, int nshards) {
+    c->shards = aligned_alloc(CACHE_LINE, sizeof(counter_shard_t) * nshards);
+    if (!c->shards)
+        return -1;
+    c->nshards = nshards;
+    for (int i = 0; i < nshards; i++)
+        atomic_init(&c->shards[i].value, 0);
+    return 0;
+}
+
+// Only thread `tid` writes shard tid, so a relaxed load+store is enough; the
+// atomic type keeps concurrent readers well-defined.
+static inline void sharded_counter_inc(sharded_counter_t *c, int tid) {
+    atomic_long *v = &c->shards[tid].value;
+    atomic_store_explicit(v, atomic_load_explicit(v, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+}
+
+static inline long sharded_counter_get(sharded_counter_t *c) {
+    long sum = 0;
+    for (int i = 0; i < c->nshards; i++)
+        sum += atomic_load_explicit(&c->shards[i].value, memory_order_relaxed);
+    return sum;
+}
+
+static inline void sharded_counter_destroy(sharded_counter_t *c) {
+    free(c->shards);
+}
+
+// ============================================================================
+//                              BATCHED COUNTER
+// ----------------------------------------------------------------------------
+// Approximate: a read sees the global value, which lags each thread by less
+// than `threshold`. Call batched_counter_flush() when a thread is done to
+// make the total exact.
+// ============================================================================
+typedef struct {
+    CACHE_ALIGNED long pending;
+} batched_local_t;
+
+typedef struct {
+    CACHE_ALIGNED atomic_long global;
+    batched_local_t          *locals;
+    int                       nlocals;
+    long                      threshold;
+} batched_counter_t;
+
+// Returns 0, or -1 if the per-thread slots cannot be allocated.
+static inline int batched_counter_init(batched_counter_t *c, int nthreads,
+                                       long threshold) {
+    c->locals = aligned_alloc(CACHE_LINE, sizeof(batched_local_t) * nthreads);
+    if (!c->locals)
+        return -1;
+    atomic_init(&c->global, 0);
+    c->nlocals   = nthreads;
+    c->threshold = threshold > 0 ? threshold : 1;
+    for (int i = 0; i < nthreads; i++)
+        c->locals[i].pending = 0;
+    return 0;
+}
+
+static inline void batched_counter_flush(batched_counter_t *c, int tid) {
+    batched_local_t *l = &c->locals[tid];
+    if (l->pending) {
+        atomic_fetch_add_explicit(&c->global, l->pending, memory_order_relaxed);
+        l->pending = 0;
+    }
+}
+
+static inline void batched_counter_inc(batched_counter_t *c, int tid) {
+    batched_local_t *l = &c->locals[tid];
+    if (++l->pending >= c->threshold)
+        batched_counter_flush(c, tid);
+}
+
+static inline long batched_counter_get(batched_counter_t *c) {
+    return atomic_load_explicit(&c->global, memory_order_relaxed);
+}
+
+static inline void batched_counter_destroy(batched_counter_t *c) {
+    free(c->locals);
+}
+
+#endif // COUNTER_H
@@ -0,0 +1,288 @@
+// locks.h
+//
+// CPSC 351 - Assignment 3 (Part I follow-up: Lock Implementations)
+// -------------------------------------------------------------------------------
+// Header-only versions of the OSTEP ch. 28 locks, for comparison against
+// pthread_mutex_t (see p1_lock_bench.c).
+//
+//   tas_lock_t      test-and-set: spin on atomic_exchange
+//   ttas_lock_t     test-and-test-and-set: spin on a plain load, exchange only
+//                   when it looks free, exponential backoff after a miss
+//   ticket_lock_t   fetch-and-add ticket; FIFO, one shared "now serving" line
+//   mcs_lock_t      queue lock; each waiter spins on its own node
+//   clh_lock_t      queue lock; each waiter spins on its predecessor's node
+//   futex_mutex_t   two-phase lock: spin briefly, then sleep in the kernel
+//                   (Drepper's "Futexes Are Tricky" mutex #2)
+//
+// MCS and CLH need a per-thread node; see their sections.
+// -------------------------------------------------------------------------------
+
+#ifndef LOCKS_H
+#define LOCKS_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "../common/bench.h"
+#include "../common/futex.h"
+
+// ============================================================================
+//                                CONFIGURATION
+// ============================================================================
+#define TTAS_BACKOFF_MIN   4      // pause iterations after the first miss
+#define TTAS_BACKOFF_MAX   4096   // cap for the exponential backoff
+#define FUTEX_SPIN_TRIES   100    // futex mutex: spin phase before sleeping
+
+// ============================================================================
+//                              TEST-AND-SET
+// ============================================================================
+typedef struct {
+    atomic_bool held;
+} tas_lock_t;
+
+static inline void tas_init(tas_lock_t *l) {
+    atomic_init(&l->held, false);
+}
+
+static inline void tas_lock(tas_lock_t *l) {
+    while (atomic_exchange_explicit(&l->held, true, memory_order_acquire))
+        cpu_relax();
+}
+
+static inline void tas_unlock(tas_lock_t *l) {
+    atomic_store_explicit(&l->held, false, memory_order_release);
+}
+
+// ============================================================================
+//                     TEST-AND-TEST-AND-SET WITH BACKOFF
+// ----------------------------------------------------------------------------
+// Waiters spin reading a shared (cached) line, so they don't bounce it around
+// with writes. After losing a race they back off for a randomized, doubling
+// number of pauses.
+// ============================================================================
+typedef struct {
+    atomic_bool held;
+} ttas_lock_t;
+
+static inline void ttas_init(ttas_lock_t *l) {
+    atomic_init(&l->held, false);
+}
+
+static inline void ttas_lock(ttas_lock_t *l) {
+    unsigned backoff = TTAS_BACKOFF_MIN;
+    unsigned seed    = (unsigned)(size_t)&backoff;   // per-thread-ish
+
+    for (;;) {
+        while (atomic_load_explicit(&l->held, memory_order_relaxed))
+            cpu_relax();
+        if (!atomic_exchange_explicit(&l->held, true, memory_order_acquire))
+            return;
+
+        seed = seed * 1103515245u + 12345u;
+        for (unsigned i = seed % backoff; i > 0; i--)
+            cpu_relax();
+        if (backoff < TTAS_BACKOFF_MAX)
+            backoff *= 2;
+    }
+}
+
+static inline void ttas_unlock(ttas_lock_t *l) {
+    atomic_store_explicit(&l->held, false, memory_order_release);
+}
+
+// ============================================================================
+//                                TICKET LOCK
+// ----------------------------------------------------------------------------
+// Take a number, wait until it is called. Strictly FIFO. `next` and `serving`
+// live on separate lines so taking a ticket doesn't disturb the spinners.
+// ============================================================================
+typedef struct {
+    CACHE_ALIGNED atomic_uint next;
+    CACHE_ALIGNED atomic_uint serving;
+} ticket_lock_t;
+
+static inline void ticket_init(ticket_lock_t *l) {
+    atomic_init(&l->next, 0);
+    atomic_init(&l->serving, 0);
+}
+
+static inline void ticket_lock(ticket_lock_t *l) {
+    unsigned me = atomic_fetch_add_explicit(&l->next, 1, memory_order_relaxed);
+    while (atomic_load_explicit(&l->serving, memory_order_acquire) != me)
+        cpu_relax();
+}
+
+static inline void ticket_unlock(ticket_lock_t *l) {
+    unsigned s = atomic_load_explicit(&l->serving, memory_order_relaxed);
+    atomic_store_explicit(&l->serving, s + 1, memory_order_release);
+}
+
+// ============================================================================
+//                                  MCS LOCK
+// ----------------------------------------------------------------------------
+// Waiters form a linked queue; each spins on a flag in its own node, and the
+// releasing thread hands the lock to its successor directly. The caller owns
+// the node (usually on its stack or per-thread) and passes the same node to
+// lock and unlock.
+// ============================================================================
+typedef struct mcs_node {
+    _Atomic(struct mcs_node *) next;
+    atomic_bool                locked;
+} CACHE_ALIGNED mcs_node_t;
+
+typedef struct {
+    _Atomic(mcs_node_t *) tail;
+} mcs_lock_t;
+
+static inline void mcs_init(mcs_lock_t *l) {
+    atomic_init(&l->tail, NULL);
+}
+
+static inline void mcs_lock(mcs_lock_t *l, mcs_node_t *me) {
+    atomic_store_explicit(&me->next, NULL, memory_order_relaxed);
+    atomic_store_explicit(&me->locked, true, memory_order_relaxed);
+
+    mcs_node_t *prev = atomic_exchange_explicit(&l->tail, me, memory_order_acq_rel);
+    if (!prev)
+        return;                                       // queue was empty
+
+    atomic_store_explicit(&prev->next, me, memory_order_release);
+    while (atomic_load_explicit(&me->locked, memory_order_acquire))
+        cpu_relax();
+}
+
+static inline void mcs_unlock(mcs_lock_t *l, mcs_node_t *me) {
+    mcs_node_t *succ = atomic_load_explicit(&me->next, memory_order_acquire);
+
+    if (!succ) {
+        // no known successor: try to swing tail back to empty
+        mcs_node_t *expected = me;
+        if (atomic_compare_exchange_strong_explicit(&l->tail, &expected, NULL,
+                                                    memory_order_release,
+                                                    memory_order_relaxed))
+            return;
+        // someone is mid-enqueue; wait for them to link in
+        while (!(succ = atomic_load_explicit(&me->next, memory_order_acquire)))
+            cpu_relax();
+    }
+    atomic_store_explicit(&succ->locked, false, memory_order_release);
+}
+
+// ============================================================================
+//                                  CLH LOCK
+// ----------------------------------------------------------------------------
+// Implicit queue: each thread enqueues its node and spins on the node of the
+// thread before it. On unlock a thread gives up its node and adopts its
+// predecessor's, so every thread needs a clh_thread_t that persists across
+// acquisitions (initialised with clh_thread_init) and the lock owns one spare
+// node (clh_init).
+// ============================================================================
+typedef struct {
+    atomic_bool locked;
+} CACHE_ALIGNED clh_node_t;
+
+typedef struct {
+    _Atomic(clh_node_t *) tail;
+} clh_lock_t;
+
+typedef struct {
+    clh_node_t *node;   // ours this round
+    clh_node_t *pred;   // the one we waited on; becomes ours after unlock
+} clh_thread_t;
+
+// Returns 0, or -1 if the dummy node cannot be allocated.
+static inline int clh_init(clh_lock_t *l) {
+    clh_node_t *dummy = aligned_alloc(CACHE_LINE, sizeof(clh_node_t));
+    if (!dummy)
+        return -1;
+    atomic_init(&dummy->locked, false);
+    atomic_init(&l->tail, dummy);
+    return 0;
+}
+
+// Frees the node currently at the tail; every thread must have released.
+static inline void clh_destroy(clh_lock_t *l) {
+    free(atomic_load(&l->tail));
+}
+
+static inline int clh_thread_init(clh_thread_t *t) {
+    t->node = aligned_alloc(CACHE_LINE, sizeof(clh_node_t));
+    t->pred = NULL;
+    if (!t->node)
+        return -1;
+    atomic_init(&t->node->locked, false);
+    return 0;
+}
+
+// Frees whichever node this thread ended up owning.
+static inline void clh_thread_destroy(clh_thread_t *t) {
+    free(t->node);
+}
+
+static inline void clh_lock(clh_lock_t *l, clh_thread_t *t) {
+    atomic_store_explicit(&t->node->locked, true, memory_order_relaxed);
+    t->pred = atomic_exchange_explicit(&l->tail, t->node, memory_order_acq_rel);
+    while (atomic_load_explicit(&t->pred->locked, memory_order_acquire))
+        cpu_relax();
+}
+
+static inline void clh_unlock(clh_lock_t *l, clh_thread_t *t) {
+    (void)l;
+    clh_node_t *mine = t->node;
+    t->node = t->pred;                                  // recycle predecessor's
+    atomic_store_explicit(&mine->locked, false, memory_order_release);
+}
+
+// ============================================================================
+//                          FUTEX TWO-PHASE MUTEX
+// ----------------------------------------------------------------------------
+// state: 0 = unlocked, 1 = locked, 2 = locked and someone may be sleeping.
+// Uncontended lock and unlock are a single atomic each and never enter the
+// kernel; unlock only calls futex_wake when the state says there may be a
+// sleeper.
+// ============================================================================
+typedef struct {
+    atomic_int state;
+} futex_mutex_t;
+
+static inline void futex_mutex_init(futex_mutex_t *m) {
+    atomic_init(&m->state, 0);
+}
+
+static inline int futex_mutex_cas(futex_mutex_t *m, int expected, int desired) {
+    atomic_compare_exchange_strong_explicit(&m->state, &expected, desired,
+                                            memory_order_acquire,
+                                            memory_order_relaxed);
+    return expected;   // the value seen
+}
+
+static inline void futex_mutex_lock(futex_mutex_t *m) {
+    int c = futex_mutex_cas(m, 0, 1);
+    if (c == 0)
+        return;                                         // fast path
+
+    // phase 1: spin a little in case the holder is about to release
+    for (int i = 0; i < FUTEX_SPIN_TRIES && c == 1; i++) {
+        cpu_relax();
+        if ((c = futex_mutex_cas(m, 0, 1)) == 0)
+            return;
+    }
+
+    // phase 2: mark contended and sleep until we grab it
+    if (c != 2)
+        c = atomic_exchange_explicit(&m->state, 2, memory_order_acquire);
+    while (c != 0) {
+        futex_wait_private(&m->state, 2);
+        c = atomic_exchange_explicit(&m->state, 2, memory_order_acquire);
+    }
+}
+
+static inline void futex_mutex_unlock(futex_mutex_t *m) {
+    if (atomic_fetch_sub_explicit(&m->state, 1, memory_order_release) != 1) {
+        atomic_store_explicit(&m->state, 0, memory_order_release);
+        futex_wake_private(&m->state, 1);
+    }
+}
+
+#endif // LOCKS_H
@@ -0,0 +1,168 @@
+// p1_counter_bench.c
+//
+// CPSC 351 - Assignment 3 (Part I follow-up: Scalable Counters)
+// -------------------------------------------------------------------------------
+// Build:
+//      gcc -O2 -pthread p1_counter_bench.c -o counter_bench
+// Run:
+//      ./counter_bench [increments_per_thread] [max_threads]
+// -------------------------------------------------------------------------------
+// Runs the p1_b.c workload (every thread increments one shared counter) for
+// each counter in counter.h, doubling the thread count from 1 up to the number
+// of cores, and prints increments/sec. The final count is checked each run.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "counter.h"
+
+// ============================================================================
+//                                CONFIGURATION
+// ============================================================================
+#define DEFAULT_ITERS     1000000   // per thread
+#define BATCH_THRESHOLD   1024      // batched counter flush interval
+
+typedef enum { V_MUTEX, V_ATOMIC, V_SHARDED, V_BATCHED, V_COUNT } variant_t;
+
+static const char *variant_names[V_COUNT] = {
+    "mutex", "atomic", "sharded", "batched"
+};
+
+// Everything a run needs; one of the counters is live per run.
+typedef struct {
+    variant_t          variant;
+    long               iters;
+    mutex_counter_t    mutex;
+    atomic_counter_t   atomic;
+    sharded_counter_t  sharded;
+    batched_counter_t  batched;
+    pthread_barrier_t  start;
+} bench_t;
+
+typedef struct {
+    bench_t *b;
+    int      tid;
+} worker_arg_t;
+
+// ============================================================================
+//                                WORKER THREAD
+// ============================================================================
+static void *worker(void *arg) {
+    worker_arg_t *w = arg;
+    bench_t      *b = w->b;
+    long          n = b->iters;
+
+    pthread_barrier_wait(&b->start);
+
+    switch (b->variant) {
+    case V_MUTEX:
+        for (long i = 0; i < n; i++)
+            mutex_counter_inc(&b->mutex);
+        break;
+    case V_ATOMIC:
+        for (long i = 0; i < n; i++)
+            atomic_counter_inc(&b->atomic);
+        break;
+    case V_SHARDED:
+        for (long i = 0; i < n; i++)
+            sharded_counter_inc(&b->sharded, w->tid);
+        break;
+    case V_BATCHED:
+        for (long i = 0; i < n; i++)
+            batched_counter_inc(&b->batched, w->tid);
+        batched_counter_flush(&b->batched, w->tid);
+        break;
+    default:
+        break;
+    }
+    return NULL;
+}
+
+// ============================================================================
+//                                  ONE RUN
+// ----------------------------------------------------------------------------
+// Returns increments/sec; prints a warning if the final count is wrong.
+// ============================================================================
+static double run(variant_t v, int nthreads, long iters) {
+    bench_t b;
+    memset(&b, 0, sizeof(b));
+    b.variant = v;
+    b.iters   = iters;
+
+    mutex_counter_init(&b.mutex);
+    atomic_counter_init(&b.atomic);
+    if (sharded_counter_init(&b.sharded, nthreads) == -1 ||
+        batched_counter_init(&b.batched, nthreads, BATCH_THRESHOLD) == -1) {
+        perror("counter init");
+        exit(1);
+    }
+    pthread_barrier_init(&b.start, NULL, nthreads + 1);
+
+    pthread_t    *threads = malloc(sizeof(pthread_t) * nthreads);
+    worker_arg_t *args    = malloc(sizeof(worker_arg_t) * nthreads);
+    for (int i = 0; i < nthreads; i++) {
+        args[i].b   = &b;
+        args[i].tid = i;
+        pthread_create(&threads[i], NULL, worker, &args[i]);
+    }
+
+    long long t0 = now_ns();
+    pthread_barrier_wait(&b.start);
+    for (int i = 0; i < nthreads; i++)
+        pthread_join(threads[i], NULL);
+    long long elapsed = now_ns() - t0;
+
+    long got = 0;
+    switch (v) {
+    case V_MUTEX:   got = mutex_counter_get(&b.mutex);     break;
+    case V_ATOMIC:  got = atomic_counter_get(&b.atomic);   break;
+    case V_SHARDED: got = sharded_counter_get(&b.sharded); break;
+    case V_BATCHED: got = batched_counter_get(&b.batched); break;
+    default: break;
+    }
+    if (got != iters * nthreads)
+        fprintf(stderr, "warning: %s counted %ld, expected %ld\n",
+                variant_names[v], got, iters * nthreads);
+
+    pthread_barrier_destroy(&b.start);
+    mutex_counter_destroy(&b.mutex);
+    sharded_counter_destroy(&b.sharded);
+    batched_counter_destroy(&b.batched);
+    free(threads);
+    free(args);
+
+    return elapsed > 0 ? (double)iters * nthreads * 1e9 / elapsed : 0.0;
+}
+
+// ============================================================================
+//                                     MAIN
+// ============================================================================
+int main(int argc, char *argv[]) {
+    long iters       = argc > 1 ? atol(argv[1]) : DEFAULT_ITERS;
+    int  max_threads = argc > 2 ? atoi(argv[2]) : cpu_count();
+    if (iters < 1 || max_threads < 1) {
+        fprintf(stderr, "usage: %s [increments_per_thread] [max_threads]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%ld increments per thread, up to %d threads (Mops/s)\n\n",
+           iters, max_threads);
+    printf("%8s", "threads");
+    for (int v = 0; v < V_COUNT; v++)
+        printf("%12s", variant_names[v]);
+    printf("\n");
+
+    for (int t = 1; ; t = (t * 2 > max_threads && t < max_threads) ? max_threads : t * 2) {
+        printf("%8d", t);
+        for (int v = 0; v < V_COUNT; v++)
+            printf("%12.1f", run((variant_t)v, t, iters) / 1e6);
+        printf("\n");
+        if (t >= max_threads)
+            break;
+    }
+    return 0;
+}
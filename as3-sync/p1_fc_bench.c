@@ -0,0 +1,259 @@
+// p1_fc_bench.c
+//
+// CPSC 351 - Assignment 3 (Part I follow-up: Flat Combining)
+// -------------------------------------------------------------------------------
+// Build:
+//      gcc -O2 -pthread p1_fc_bench.c -o fc_bench
+// Run:
+//      ./fc_bench [-d ms] [-t max_threads]
+// -------------------------------------------------------------------------------
+// Two workloads, each for a fixed time per thread count (doubling up to max):
+//
+//   counter   every thread increments one shared counter (p1_b.c)
+//             mutex    mutex_counter_t from counter.h
+//             atomic   atomic_counter_t from counter.h
+//             fc       flat-combined increments
+//
+//   queue     every thread alternates push / pop on one shared FIFO
+//             mutex    pthread_mutex_t around the queue
+//             fc       flat-combined push / pop
+//
+// Prints Mops/s per variant, and for fc the average batch size (operations
+// applied per combining session) - the bigger it is, the more lock handoffs
+// and cache-line moves were saved.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "counter.h"
+#include "flat_combining.h"
+
+// ============================================================================
+//                                CONFIGURATION
+// ============================================================================
+#define DEFAULT_MS  200
+#define QUEUE_CAP   4096      // > max threads, so push never finds it full
+
+typedef enum { W_COUNTER, W_QUEUE } workload_t;
+typedef enum { V_MUTEX, V_ATOMIC, V_FC } variant_t;
+
+enum { OP_INC, OP_PUSH, OP_POP };
+
+// ============================================================================
+//                          SEQUENTIAL DATA STRUCTURES
+// ----------------------------------------------------------------------------
+// Plain single-threaded code; the mutex or the combiner makes it safe.
+// ============================================================================
+typedef struct {
+    long   items[QUEUE_CAP];
+    size_t head, tail;        // head: next pop, tail: next push
+} seq_queue_t;
+
+static long seq_queue_push(seq_queue_t *q, long v) {
+    if (q->tail - q->head == QUEUE_CAP)
+        return -1;
+    q->items[q->tail++ % QUEUE_CAP] = v;
+    return 0;
+}
+
+static long seq_queue_pop(seq_queue_t *q) {
+    if (q->tail == q->head)
+        return -1;
+    return q->items[q->head++ % QUEUE_CAP];
+}
+
+// fc_apply_fn for both workloads
+static long apply(void *state, int op, long arg) {
+    switch (op) {
+    case OP_INC:  return ++*(long *)state;
+    case OP_PUSH: return seq_queue_push(state, arg);
+    case OP_POP:  return seq_queue_pop(state);
+    default:      return -1;
+    }
+}
+
+// ============================================================================
+//                                  BENCH STATE
+// ============================================================================
+typedef struct {
+    workload_t        workload;
+    variant_t         variant;
+
+    mutex_counter_t   mcounter;
+    atomic_counter_t  acounter;
+    long              fc_counter;    // touched only by the combiner
+
+    pthread_mutex_t   qlock;
+    seq_queue_t       queue;
+
+    fc_t              fc;
+    CACHE_ALIGNED atomic_bool stop;
+    pthread_barrier_t start;
+} bench_t;
+
+typedef struct {
+    bench_t *b;
+    int      tid;
+    long     ops;
+} CACHE_ALIGNED worker_t;
+
+// ============================================================================
+//                                WORKER THREAD
+// ============================================================================
+static void *worker(void *arg) {
+    worker_t *w = arg;
+    bench_t  *b = w->b;
+    long      n = 0;
+
+    pthread_barrier_wait(&b->start);
+
+    while (!atomic_load_explicit(&b->stop, memory_order_relaxed)) {
+        if (b->workload == W_COUNTER) {
+            switch (b->variant) {
+            case V_MUTEX:  mutex_counter_inc(&b->mcounter);           break;
+            case V_ATOMIC: atomic_counter_inc(&b->acounter);          break;
+            case V_FC:     fc_execute(&b->fc, w->tid, OP_INC, 0);     break;
+            }
+            n++;
+        } else {
+            if (b->variant == V_FC) {
+                fc_execute(&b->fc, w->tid, OP_PUSH, n);
+                fc_execute(&b->fc, w->tid, OP_POP, 0);
+            } else {
+                pthread_mutex_lock(&b->qlock);
+                seq_queue_push(&b->queue, n);
+                pthread_mutex_unlock(&b->qlock);
+                pthread_mutex_lock(&b->qlock);
+                seq_queue_pop(&b->queue);
+                pthread_mutex_unlock(&b->qlock);
+            }
+            n += 2;
+        }
+    }
+    w->ops = n;
+    return NULL;
+}
+
+// ============================================================================
+//                                  ONE RUN
+// ----------------------------------------------------------------------------
+// Returns Mops/s; *batch gets the fc average batch size (0 for others).
+// ============================================================================
+static double run(workload_t wl, variant_t v, int nthreads, long ms, double *batch) {
+    bench_t *b = aligned_alloc(CACHE_LINE, sizeof(bench_t));
+    memset(b, 0, sizeof(*b));
+    b->workload = wl;
+    b->variant  = v;
+    mutex_counter_init(&b->mcounter);
+    atomic_counter_init(&b->acounter);
+    pthread_mutex_init(&b->qlock, NULL);
+    atomic_init(&b->stop, false);
+    void *state = (wl == W_COUNTER) ? (void *)&b->fc_counter : (void *)&b->queue;
+    if (fc_init(&b->fc, nthreads, state, apply) == -1) {
+        perror("fc_init");
+        exit(1);
+    }
+    pthread_barrier_init(&b->start, NULL, nthreads + 1);
+
+    pthread_t *threads = malloc(sizeof(pthread_t) * nthreads);
+    worker_t  *ws      = aligned_alloc(CACHE_LINE, sizeof(worker_t) * nthreads);
+    for (int i = 0; i < nthreads; i++) {
+        ws[i].b   = b;
+        ws[i].tid = i;
+        ws[i].ops = 0;
+        pthread_create(&threads[i], NULL, worker, &ws[i]);
+    }
+
+    long long t0 = now_ns();
+    pthread_barrier_wait(&b->start);
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+    atomic_store(&b->stop, true);
+    for (int i = 0; i < nthreads; i++)
+        pthread_join(threads[i], NULL);
+    double secs = (now_ns() - t0) / 1e9;
+
+    long total = 0;
+    for (int i = 0; i < nthreads; i++)
+        total += ws[i].ops;
+
+    // sanity: counters must match exactly, the queue must be drained
+    long expect = -1, got = 0;
+    if (wl == W_COUNTER) {
+        expect = total;
+        got = v == V_MUTEX  ? mutex_counter_get(&b->mcounter)
+            : v == V_ATOMIC ? atomic_counter_get(&b->acounter)
+            :                 b->fc_counter;
+    } else {
+        expect = 0;
+        got    = (long)(b->queue.tail - b->queue.head);
+    }
+    if (got != expect)
+        fprintf(stderr, "warning: expected %ld, got %ld\n", expect, got);
+
+    *batch = (v == V_FC && b->fc.sessions) ? (double)b->fc.applied / b->fc.sessions : 0.0;
+
+    fc_destroy(&b->fc);
+    mutex_counter_destroy(&b->mcounter);
+    pthread_mutex_destroy(&b->qlock);
+    pthread_barrier_destroy(&b->start);
+    free(ws);
+    free(threads);
+    free(b);
+    return total / secs / 1e6;
+}
+
+// ============================================================================
+//                                     MAIN
+// ============================================================================
+int main(int argc, char *argv[]) {
+    long ms          = DEFAULT_MS;
+    int  max_threads = cpu_count();
+    int  opt;
+
+    while ((opt = getopt(argc, argv, "d:t:")) != -1) {
+        switch (opt) {
+        case 'd': ms          = atol(optarg); break;
+        case 't': max_threads = atoi(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [-d ms] [-t max_threads]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (ms < 1 || max_threads < 1 || max_threads >= QUEUE_CAP) {
+        fprintf(stderr, "bad -d / -t\n");
+        return 1;
+    }
+
+    printf("%ld ms per point (Mops/s; fc batch = ops per combining session)\n\n", ms);
+
+    printf("counter\n%8s %10s %10s %10s %10s\n", "threads", "mutex", "atomic", "fc", "fc batch");
+    for (int t = 1; ; t = (t * 2 > max_threads && t < max_threads) ? max_threads : t * 2) {
+        double batch;
+        double m = run(W_COUNTER, V_MUTEX, t, ms, &batch);
+        double a = run(W_COUNTER, V_ATOMIC, t, ms, &batch);
+        double f = run(W_COUNTER, V_FC, t, ms, &batch);
+        printf("%8d %10.2f %10.2f %10.2f %10.2f\n", t, m, a, f, batch);
+        fflush(stdout);
+        if (t >= max_threads)
+            break;
+    }
+
+    printf("\nqueue\n%8s %10s %10s %10s\n", "threads", "mutex", "fc", "fc batch");
+    for (int t = 1; ; t = (t * 2 > max_threads && t < max_threads) ? max_threads : t * 2) {
+        double batch;
+        double m = run(W_QUEUE, V_MUTEX, t, ms, &batch);
+        double f = run(W_QUEUE, V_FC, t, ms, &batch);
+        printf("%8d %10.2f %10.2f %10.2f\n", t, m, f, batch);
+        fflush(stdout);
+        if (t >= max_threads)
+            break;
+    }
+    return 0;
+}
@@ -0,0 +1,256 @@
+// p1_lock_bench.c
+//
+// CPSC 351 - Assignment 3 (Part I follow-up: Lock Implementations)
+// -------------------------------------------------------------------------------
+// Build:
+//      gcc -O2 -pthread p1_lock_bench.c -o lock_bench
+// Run:
+//      ./lock_bench [-d ms] [-c cs_len] [-o outside_len] [-t max_threads] [-l lock]
+//
+//      -d   run length per data point in milliseconds     (default 200)
+//      -c   shared-counter increments inside the lock     (default 1, = p1_b.c)
+//      -o   pause iterations between acquisitions         (default 0)
+//      -t   largest thread count                          (default: #cores)
+//      -l   only run this lock (pthread, tas, ttas, ticket, mcs, clh, futex)
+// -------------------------------------------------------------------------------
+// Every thread loops { lock; counter++ x cs_len; unlock; outside work } until
+// the time is up. For each lock and thread count (doubling up to max) it
+// prints total throughput and two fairness numbers over the per-thread
+// acquisition counts:
+//      jain     Jain's index, 1.0 = perfectly even, 1/threads = one thread won
+//      min/max  fewest acquisitions divided by most
+// The shared counter is checked against the acquisitions to catch a broken
+// lock.
+
+#define _GNU_SOURCE             // syscall() in futex.h, usleep()
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "locks.h"
+
+// ============================================================================
+//                                CONFIGURATION
+// ============================================================================
+#define DEFAULT_MS      200
+#define DEFAULT_CS_LEN  1
+#define DEFAULT_OUT_LEN 0
+
+typedef enum { L_PTHREAD, L_TAS, L_TTAS, L_TICKET, L_MCS, L_CLH, L_FUTEX, L_COUNT } lock_kind_t;
+
+static const char *lock_names[L_COUNT] = {
+    "pthread", "tas", "ttas", "ticket", "mcs", "clh", "futex"
+};
+
+// All the locks; one is used per run.
+typedef struct {
+    lock_kind_t      kind;
+    pthread_mutex_t  pthread;
+    tas_lock_t       tas;
+    ttas_lock_t      ttas;
+    ticket_lock_t    ticket;
+    mcs_lock_t       mcs;
+    clh_lock_t       clh;
+    futex_mutex_t    futex;
+
+    long             cs_len, out_len;
+    CACHE_ALIGNED volatile long counter;   // the protected data
+    CACHE_ALIGNED atomic_bool   stop;
+    pthread_barrier_t start;
+} bench_t;
+
+typedef struct {
+    bench_t     *b;
+    mcs_node_t   mcs_node;
+    clh_thread_t clh;
+    long         acquisitions;
+} CACHE_ALIGNED worker_t;
+
+// ============================================================================
+//                            UNIFORM LOCK / UNLOCK
+// ============================================================================
+static inline void bench_lock(bench_t *b, worker_t *w) {
+    switch (b->kind) {
+    case L_PTHREAD: pthread_mutex_lock(&b->pthread);   break;
+    case L_TAS:     tas_lock(&b->tas);                 break;
+    case L_TTAS:    ttas_lock(&b->ttas);               break;
+    case L_TICKET:  ticket_lock(&b->ticket);           break;
+    case L_MCS:     mcs_lock(&b->mcs, &w->mcs_node);   break;
+    case L_CLH:     clh_lock(&b->clh, &w->clh);        break;
+    case L_FUTEX:   futex_mutex_lock(&b->futex);       break;
+    default: break;
+    }
+}
+
+static inline void bench_unlock(bench_t *b, worker_t *w) {
+    switch (b->kind) {
+    case L_PTHREAD: pthread_mutex_unlock(&b->pthread); break;
+    case L_TAS:     tas_unlock(&b->tas);               break;
+    case L_TTAS:    ttas_unlock(&b->ttas);             break;
+    case L_TICKET:  ticket_unlock(&b->ticket);         break;
+    case L_MCS:     mcs_unlock(&b->mcs, &w->mcs_node); break;
+    case L_CLH:     clh_unlock(&b->clh, &w->clh);      break;
+    case L_FUTEX:   futex_mutex_unlock(&b->futex);     break;
+    default: break;
+    }
+}
+
+// ============================================================================
+//                                WORKER THREAD
+// ============================================================================
+static void *worker(void *arg) {
+    worker_t *w = arg;
+    bench_t  *b = w->b;
+
+    pthread_barrier_wait(&b->start);
+
+    while (!atomic_load_explicit(&b->stop, memory_order_relaxed)) {
+        bench_lock(b, w);
+        for (long i = 0; i < b->cs_len; i++)
+            b->counter++;
+        bench_unlock(b, w);
+        w->acquisitions++;
+
+        for (long i = 0; i < b->out_len; i++)
+            cpu_relax();
+    }
+    return NULL;
+}
+
+// ============================================================================
+//                                  ONE RUN
+// ============================================================================
+typedef struct {
+    double mops;      // acquisitions per second / 1e6
+    double jain;
+    double min_max;
+} result_t;
+
+static result_t run(lock_kind_t kind, int nthreads, long ms, long cs_len, long out_len) {
+    bench_t *b = aligned_alloc(CACHE_LINE, sizeof(bench_t));
+    memset(b, 0, sizeof(*b));
+    b->kind    = kind;
+    b->cs_len  = cs_len;
+    b->out_len = out_len;
+    atomic_init(&b->stop, false);
+
+    pthread_mutex_init(&b->pthread, NULL);
+    tas_init(&b->tas);
+    ttas_init(&b->ttas);
+    ticket_init(&b->ticket);
+    mcs_init(&b->mcs);
+    futex_mutex_init(&b->futex);
+    if (clh_init(&b->clh) == -1) {
+        perror("clh_init");
+        exit(1);
+    }
+    pthread_barrier_init(&b->start, NULL, nthreads + 1);
+
+    pthread_t *threads = malloc(sizeof(pthread_t) * nthreads);
+    worker_t  *ws      = aligned_alloc(CACHE_LINE, sizeof(worker_t) * nthreads);
+    memset(ws, 0, sizeof(worker_t) * nthreads);
+
+    for (int i = 0; i < nthreads; i++) {
+        ws[i].b = b;
+        if (clh_thread_init(&ws[i].clh) == -1) {
+            perror("clh_thread_init");
+            exit(1);
+        }
+        pthread_create(&threads[i], NULL, worker, &ws[i]);
+    }
+
+    long long t0 = now_ns();
+    pthread_barrier_wait(&b->start);
+    usleep((useconds_t)(ms * 1000));
+    atomic_store(&b->stop, true);
+    for (int i = 0; i < nthreads; i++)
+        pthread_join(threads[i], NULL);
+    double secs = (now_ns() - t0) / 1e9;
+
+    // throughput and fairness
+    long   total = 0, lo = -1, hi = 0;
+    double sum_sq = 0.0;
+    for (int i = 0; i < nthreads; i++) {
+        long a = ws[i].acquisitions;
+        total  += a;
+        sum_sq += (double)a * a;
+        if (lo < 0 || a < lo) lo = a;
+        if (a > hi)           hi = a;
+    }
+    if (b->counter != total * cs_len)
+        fprintf(stderr, "warning: %s lost updates (%ld != %ld)\n",
+                lock_names[kind], b->counter, total * cs_len);
+
+    result_t r;
+    r.mops    = total / secs / 1e6;
+    r.jain    = sum_sq > 0 ? (double)total * total / (nthreads * sum_sq) : 0.0;
+    r.min_max = hi > 0 ? (double)lo / hi : 0.0;
+
+    for (int i = 0; i < nthreads; i++)
+        clh_thread_destroy(&ws[i].clh);
+    clh_destroy(&b->clh);
+    pthread_barrier_destroy(&b->start);
+    pthread_mutex_destroy(&b->pthread);
+    free(ws);
+    free(threads);
+    free(b);
+    return r;
+}
+
+// ============================================================================
+//                                     MAIN
+// ============================================================================
+int main(int argc, char *argv[]) {
+    long ms          = DEFAULT_MS;
+    long cs_len      = DEFAULT_CS_LEN;
+    long out_len     = DEFAULT_OUT_LEN;
+    int  max_threads = cpu_count();
+    int  only        = -1;
+    int  opt;
+
+    while ((opt = getopt(argc, argv, "d:c:o:t:l:")) != -1) {
+        switch (opt) {
+        case 'd': ms          = atol(optarg); break;
+        case 'c': cs_len      = atol(optarg); break;
+        case 'o': out_len     = atol(optarg); break;
+        case 't': max_threads = atoi(optarg); break;
+        case 'l':
+            for (int k = 0; k < L_COUNT; k++)
+                if (strcmp(optarg, lock_names[k]) == 0)
+                    only = k;
+            if (only == -1) {
+                fprintf(stderr, "unknown lock '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        default:
+            fprintf(stderr,
+                    "usage: %s [-d ms] [-c cs_len] [-o outside_len] [-t max_threads] [-l lock]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (ms < 1 || cs_len < 0 || out_len < 0 || max_threads < 1) {
+        fprintf(stderr, "all options must be positive\n");
+        return 1;
+    }
+
+    printf("%ld ms per point, critical section %ld, outside %ld\n\n", ms, cs_len, out_len);
+    printf("%-8s %8s %12s %8s %8s\n", "lock", "threads", "Mops/s", "jain", "min/max");
+
+    for (int k = 0; k < L_COUNT; k++) {
+        if (only != -1 && k != only)
+            continue;
+        for (int t = 1; ; t = (t * 2 > max_threads && t < max_threads) ? max_threads : t * 2) {
+            result_t r = run((lock_kind_t)k, t, ms, cs_len, out_len);
+            printf("%-8s %8d %12.2f %8.3f %8.3f\n", lock_names[k], t, r.mops, r.jain, r.min_max);
+            fflush(stdout);
+            if (t >= max_threads)
+                break;
+        }
+    }
+    return 0;
+}
@@ -4,125 +4,874 @@
 // -------------------------------------------------------------------------------
 // Build:
 //      gcc -pthread p2_thread_sync.c -o p2
+//      gcc -pthread -include ../common/lock_prof.h p2_thread_sync.c -o p2
+//                          (mutex/condvar contention report at exit, see there)
 // Run:
-//      ./p2
+//      ./p2 [-a strategy] [-n philosophers] [-s stripes] [-w us] [-T file]
+//                                                  (the demo: sleeps, prints)
+//      ./p2 [-a strategy,...|all] [-n philosophers] [-s stripes] [-w us,...]
+//           -d ms [-t think] [-e eat] [-v] [-C] [-T file]
+//                                                  (benchmark, see below)
+//
+//      -a   monitor | hierarchy | waiter | chandy | cas  (default monitor)
+//           a comma list or `all` runs each in turn and compares them
+//      -n   philosophers                                  (default 5)
+//      -s   monitor: lock stripes; seat i is guarded by lock i % s
+//           (default n); -s 1 is the original single global mutex
+//      -w   monitor: aging bound in microseconds, 0 = greedy (default 0);
+//           a comma list benchmarks the monitor once per bound
+//      -T   record hungry / eating / blocked spans per thread
+//           (../common/trace.h) and write them to file as Chrome-trace
+//           JSON at exit; the demo then prints nothing and stops on Ctrl-C
+//      -d   benchmark for ms milliseconds: no sleeps, no printing
+//      -t   benchmark: spin iterations while thinking     (default 0)
+//      -e   benchmark: spin iterations while eating       (default 0)
+//      -v   benchmark: also list every philosopher's meal count
+//      -C   benchmark: for each CPU count (doubling up to #cores) run every
+//           chosen strategy, one line per CPU count
 // -------------------------------------------------------------------------------
+// The benchmark prints one row per strategy:
+//      meals/sec            the whole table
+//      meals per seat       min / max (and who), Jain's index (1.0 = even,
+//                           1/N = one philosopher ate everything), min/max
+//      wait                 hungry -> eating latency percentiles, from
+//                           per-philosopher histograms (4 buckets per power
+//                           of two, so values are within 25%)
+// A starving seat shows up as a low min, a low Jain's index, or a huge max
+// wait.
+// -------------------------------------------------------------------------------
+// Strategies (each is a pickup/putdown pair; the harness doesn't care which):
+//
+// monitor    Tanenbaum's, below.
+// hierarchy  One mutex per chopstick, always locked lower index first
+//            (Dijkstra's resource ordering).
+// waiter     An arbitrator semaphore of N-1 (../common/sem.h) in front of the
+//            chopstick mutexes: with at most N-1 seated, someone always gets
+//            both chopsticks.
+// chandy     Chandy-Misra: every fork has an owner and is clean or dirty.
+//            Forks start dirty with the lower-numbered neighbour. A hungry
+//            philosopher asks for each fork it lacks; the owner must hand
+//            over a dirty fork it isn't eating with (cleaning it) and keeps a
+//            clean one until it has eaten. Eating dirties both forks, so
+//            after a meal they go to whoever asked. The messages are a
+//            `requested` flag and the handover itself, under the fork's
+//            mutex; a philosopher whose request is pending sleeps on its
+//            seat until a fork is handed to it.
+// cas        No mutexes or condvars. Each fork is one atomic int (0 free,
+//            1 taken, 2 taken and the neighbour is asleep on it). Pickup
+//            CASes the lower fork 0 -> 1, then the higher; if the higher
+//            is taken it puts the lower back and waits on the higher one,
+//            so nobody sits on one fork while waiting for the other.
+//            Waiting is a short spin, then a futex on the fork word.
+//            Putdown is one exchange per fork, plus a FUTEX_WAKE only if
+//            the word said 2: an uncontended meal makes no system call.
+//
+// The monitor is Tanenbaum's: a philosopher may eat when hungry and neither
+// neighbour is eating, test(i) checks that and hands over, and a hungry
+// philosopher waits on its own condition variable.
+//
+// test(i) only reads seats i-1, i, i+1, so there is no need for one mutex
+// around the whole table. Each seat's state belongs to a lock stripe, and an
+// operation locks just the stripes it touches, always in increasing stripe
+// order (no deadlock):
+//      pickup(i)     seats i-1 .. i+1     (test(i))
+//      putdown(i)    seats i-2 .. i+2     (test(i-1), test(i+1))
+// With one stripe per seat, philosophers on opposite sides of a big table
+// never touch the same lock or cache line.
+//
+// Greedy test(i) lets i eat whenever neither neighbour is eating, so two
+// neighbours taking turns can starve the seat between them forever. With
+// -w, test(i) also refuses while a neighbour has been hungry longer than the
+// bound and longer than i. Once a seat has starved past the bound, its
+// neighbours stop starting meals, and it gets both chopsticks within about
+// the bound plus one meal (plus however long the scheduler keeps a thread
+// off a CPU). A seat only ever defers to an older hungry seat, so the oldest
+// never defers and nothing deadlocks. The cost is chopsticks left idle while
+// a starving seat waits for its second neighbour, and a clock read per
+// test(). Compare the rows of
+//      ./p2 -d 1000 -n 64 -w 0,1000,100,10
+// for throughput against max wait.
+
+#define _GNU_SOURCE             // pthread_attr_setaffinity_np, futex (sem.h)
 
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <pthread.h>
+#include <string.h>
+#include <time.h>
 #include <unistd.h>
 
+#include "../common/bench.h"
+#include "../common/futex.h"
+#include "../common/sem.h"
+#include "../common/trace.h"
+
 
 // ============================================================================
 //                                CONFIGURATION
 // ============================================================================
-#define N 5
+#define DEFAULT_N     5
+#define STACK_SIZE    (64 * 1024)   // thousands of philosophers = thousands of threads
 #define LEFT(i)  ((i + N - 1) % N)
 #define RIGHT(i) ((i + 1) % N)
+#define SEAT(i)  (((i) % N + N) % N)
+#define LAT_BUCKETS   256           // see lat_bucket()
+#define CAS_SPIN      100           // cas: fork checks before sleeping on it
+#define MAX_AGES      8             // -w list length
+#define TRACE_EVENTS  4096          // -T: last events kept per philosopher
+#define LFORK(i) LEFT(i)            // fork k lies between philosophers k and k+1
+#define RFORK(i) (i)
 
 typedef enum { THINKING, HUNGRY, EATING } state_t;
 
-state_t state[N];                                  // Shared state array
-pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER; // One mutex
-pthread_cond_t cond[N];                            // Shared condition array
+typedef struct {
+    state_t        state;
+    pthread_cond_t cond;                           // waits here while HUNGRY
+    unsigned       mail;                           // chandy: forks handed to us
+    long long      hungry_since;                   // monitor -w: ns, set in pickup
+} CACHE_ALIGNED seat_t;
+
+typedef struct {
+    pthread_mutex_t mutex;
+} CACHE_ALIGNED stripe_t;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    int             owner;                         // chandy: who holds it
+    bool            dirty;                         // chandy: eaten with since handover
+    bool            in_use;                        // chandy: owner is eating
+    bool            requested;                     // chandy: the other side wants it
+    atomic_int      word;                          // cas: 0 free, 1 taken, 2 + sleeper
+} CACHE_ALIGNED fork_t;
+
+typedef struct {
+    const char *name;
+    void      (*init)(void);                       // after the common setup; may be NULL
+    void      (*pickup)(int i);
+    void      (*putdown)(int i);
+} strategy_t;
+
+typedef struct {
+    int       id;
+    long      meals;
+    long long max_wait;                            // ns
+    long      hist[LAT_BUCKETS];                   // hungry -> eating waits
+} CACHE_ALIGNED phil_t;
+
+typedef struct {
+    double    meals_per_sec;
+    long      min_meals, max_meals;
+    int       min_id, max_id;
+    double    jain;
+    long long p50, p90, p99, p999, max_wait;        // ns
+} result_t;
+
+static int        N;                               // philosophers
+static int        nstripes;                        // lock stripes
+static seat_t    *seats;                           // Shared state array
+static stripe_t  *stripes;                         // Seat i -> stripes[i % nstripes]
+static fork_t    *forks;                           // forks[k] between k and k+1
+static semaphore  waiter;                          // waiter: N-1 seats
+static const strategy_t *strategy;
+static long long  age_ns;                          // monitor: aging bound, 0 = greedy
+static int        quiet;                           // benchmark: no sleep/printf
+static int        tracing;                         // -T: trace events, no printf
+static int        verbose;                         // benchmark: list meal counts
+static long       think_work, eat_work;            // benchmark: spin iterations
+static atomic_bool stop;
+
+#define LOCK_OF(i) (&stripes[(i) % nstripes].mutex)
 
 // ============================================================================
-//                            MONITOR FUNCTIONS
+//                              LATENCY HISTOGRAM
+// ----------------------------------------------------------------------------
+// Bucket = 4 * floor(log2 ns) plus the next two bits, so every power of two
+// is split in four; 0..7 ns map to themselves.
 // ============================================================================
+static int lat_bucket(long long ns) {
+    if (ns < 8)
+        return ns < 0 ? 0 : (int)ns;
+    int msb = 63 - __builtin_clzll((unsigned long long)ns);
+    return 4 * (msb - 1) + (int)((ns >> (msb - 2)) & 3);
+}
 
-// Checks if a philosopher can eat
-void test(int i) {
-    if (state[i]        == HUNGRY &&
-        state[LEFT(i)]  != EATING &&
-        state[RIGHT(i)] != EATING) 
-    {     
-        state[i] = EATING;
-        pthread_cond_signal(&cond[i]);
+// Smallest value that lands in bucket b.
+static long long lat_lower(int b) {
+    if (b < 8)
+        return b;
+    int msb = b / 4 + 1;
+    return (long long)(4 + b % 4) << (msb - 2);
+}
+
+static long long lat_percentile(const long hist[], long total, double q) {
+    long want = (long)(q * total), seen = 0;
+    for (int b = 0; b < LAT_BUCKETS; b++) {
+        seen += hist[b];
+        if (seen > want)
+            return lat_lower(b);
     }
+    return lat_lower(LAT_BUCKETS - 1);
 }
 
+static void spin_work(long iters) {
+    for (volatile long k = 0; k < iters; k++)
+        ;
+}
 
 // ============================================================================
-//                          PHILOSOPHER THREAD FUNCTION
+//                                 SEAT LOCKING
 // ----------------------------------------------------------------------------
-// Called by philosopher when hungry
+// Locks the stripes of seats i-radius .. i+radius in increasing order
+// (duplicates skipped: small tables, few stripes). Returns how many were
+// locked; their indices are in held[].
 // ============================================================================
-void pickup_chopsticks(int i) {
-    pthread_mutex_lock(&mutex);
+static int lock_seats(int i, int radius, int held[]) {
+    int k = 0;
+    for (int d = -radius; d <= radius; d++) {
+        int s = SEAT(i + d) % nstripes;
+        int j = k;
+        while (j > 0 && held[j - 1] > s) {         // insertion sort
+            held[j] = held[j - 1];
+            j--;
+        }
+        if (j > 0 && held[j - 1] == s) {           // already in: undo shift
+            memmove(&held[j], &held[j + 1], sizeof(int) * (k - j));
+            continue;
+        }
+        held[j] = s;
+        k++;
+    }
+    for (int j = 0; j < k; j++)
+        pthread_mutex_lock(&stripes[held[j]].mutex);
+    return k;
+}
+
+static void unlock_seats(const int held[], int k, int keep) {
+    for (int j = k - 1; j >= 0; j--)
+        if (held[j] != keep)
+            pthread_mutex_unlock(&stripes[held[j]].mutex);
+}
+
+// ============================================================================
+//                              STRATEGY: MONITOR
+// ============================================================================
+
+// True if i must let a neighbour that has starved past the aging bound,
+// and for longer than i, eat first
+static bool defers(int i) {
+    if (age_ns == 0)
+        return false;
+    long long now = now_ns();
+    int nb[2] = { LEFT(i), RIGHT(i) };
+    for (int j = 0; j < 2; j++) {
+        seat_t *s = &seats[nb[j]];
+        if (s->state == HUNGRY && now - s->hungry_since > age_ns &&
+            s->hungry_since < seats[i].hungry_since)
+            return true;
+    }
+    return false;
+}
 
-    printf("Philosopher %d is hungry and trying to pick up chopsticks...\n", i);
-    state[i] = HUNGRY;
+// Checks if a philosopher can eat (stripes of i-1 .. i+1 held)
+static void test(int i) {
+    if (seats[i].state        == HUNGRY &&
+        seats[LEFT(i)].state  != EATING &&
+        seats[RIGHT(i)].state != EATING &&
+        !defers(i))
+    {
+        seats[i].state = EATING;
+        pthread_cond_signal(&seats[i].cond);
+    }
+}
+
+
+// Called by philosopher when hungry
+static void monitor_pickup(int i) {
+    int held[5];
+    int k = lock_seats(i, 1, held);
+
+    seats[i].state = HUNGRY;
+    if (age_ns)
+        seats[i].hungry_since = now_ns();
 
     test(i);
 
-    while (state[i] != EATING)
-        pthread_cond_wait(&cond[i], &mutex);
+    // keep only our own stripe: whoever makes us EATING must hold it
+    unlock_seats(held, k, i % nstripes);
+    while (seats[i].state != EATING) {
+        trace_begin("blocked");
+        pthread_cond_wait(&seats[i].cond, LOCK_OF(i));
+        trace_end("blocked");
+    }
+
+    pthread_mutex_unlock(LOCK_OF(i));
+}
+
+// Called by philosopher when done eating
+static void monitor_putdown(int i) {
+    int held[5];
+    int k = lock_seats(i, 2, held);
+
+    seats[i].state = THINKING;
 
-    printf("Philosopher %d is eating...\n", i);
+    // Notify neighbors
+    test(LEFT(i));
+    test(RIGHT(i));
 
-    pthread_mutex_unlock(&mutex);
+    unlock_seats(held, k, -1);
 }
 
+// ============================================================================
+//                             STRATEGY: HIERARCHY
+// ============================================================================
+static void hierarchy_pickup(int i) {
+    int a = LFORK(i) < RFORK(i) ? LFORK(i) : RFORK(i);
+    int b = LFORK(i) ^ RFORK(i) ^ a;
+
+    pthread_mutex_lock(&forks[a].mutex);
+    pthread_mutex_lock(&forks[b].mutex);
+}
+
+static void hierarchy_putdown(int i) {
+    pthread_mutex_unlock(&forks[LFORK(i)].mutex);
+    pthread_mutex_unlock(&forks[RFORK(i)].mutex);
+}
 
 // ============================================================================
-//                          PHILOSOPHER THREAD FUNCTION
+//                              STRATEGY: WAITER
+// ============================================================================
+static void waiter_init(void) {
+    sem_init_value(&waiter, N - 1);
+}
+
+// Left then right, no ordering: the waiter keeps one seat empty
+static void waiter_pickup(int i) {
+    sem_wait(&waiter);
+    pthread_mutex_lock(&forks[LFORK(i)].mutex);
+    pthread_mutex_lock(&forks[RFORK(i)].mutex);
+}
+
+static void waiter_putdown(int i) {
+    pthread_mutex_unlock(&forks[RFORK(i)].mutex);
+    pthread_mutex_unlock(&forks[LFORK(i)].mutex);
+    sem_post(&waiter);
+}
+
+// ============================================================================
+//                           STRATEGY: CHANDY-MISRA
+// ============================================================================
+static void chandy_init(void) {
+    for (int k = 0; k < N; k++) {
+        forks[k].owner     = (k == N - 1) ? 0 : k;   // lower-numbered neighbour
+        forks[k].dirty     = true;
+        forks[k].in_use    = false;
+        forks[k].requested = false;
+    }
+}
+
+// Tells philosopher `to` that a fork has been handed to it
+static void chandy_deliver(int to) {
+    pthread_mutex_lock(LOCK_OF(to));
+    seats[to].mail++;
+    pthread_cond_signal(&seats[to].cond);
+    pthread_mutex_unlock(LOCK_OF(to));
+}
+
+static void chandy_pickup(int i) {
+    int f[2] = { LFORK(i), RFORK(i) };
+    if (f[0] > f[1]) {
+        f[0] = RFORK(i);
+        f[1] = LFORK(i);
+    }
+
+    for (;;) {
+        pthread_mutex_lock(LOCK_OF(i));
+        unsigned seen = seats[i].mail;
+        pthread_mutex_unlock(LOCK_OF(i));
+
+        // Both fork mutexes at once: a dirty fork we own could otherwise
+        // be taken between looking at one fork and the other
+        pthread_mutex_lock(&forks[f[0]].mutex);
+        pthread_mutex_lock(&forks[f[1]].mutex);
+        int have = 0;
+        for (int j = 0; j < 2; j++) {
+            fork_t *fk = &forks[f[j]];
+            if (fk->owner == i) {
+                have++;
+            } else if (fk->dirty && !fk->in_use) {
+                // the owner would have to hand it over on request anyway
+                fk->owner     = i;
+                fk->dirty     = false;
+                fk->requested = false;
+                have++;
+            } else {
+                fk->requested = true;                  // it goes to us after their meal
+            }
+        }
+        if (have == 2) {
+            forks[f[0]].in_use = forks[f[1]].in_use = true;
+            forks[f[0]].dirty  = forks[f[1]].dirty  = true;
+        }
+        pthread_mutex_unlock(&forks[f[1]].mutex);
+        pthread_mutex_unlock(&forks[f[0]].mutex);
+        if (have == 2)
+            return;
+
+        pthread_mutex_lock(LOCK_OF(i));
+        while (seats[i].mail == seen) {
+            trace_begin("blocked");
+            pthread_cond_wait(&seats[i].cond, LOCK_OF(i));
+            trace_end("blocked");
+        }
+        pthread_mutex_unlock(LOCK_OF(i));
+    }
+}
+
+static void chandy_putdown(int i) {
+    int f[2]    = { LFORK(i), RFORK(i) };
+    int peer[2] = { LEFT(i), RIGHT(i) };
+    int sent[2] = { 0, 0 };
+    int lo      = f[0] < f[1] ? 0 : 1;
+
+    pthread_mutex_lock(&forks[f[lo]].mutex);
+    pthread_mutex_lock(&forks[f[!lo]].mutex);
+    for (int j = 0; j < 2; j++) {
+        fork_t *fk = &forks[f[j]];
+        fk->in_use = false;
+        if (fk->requested) {
+            fk->owner     = peer[j];
+            fk->dirty     = false;
+            fk->requested = false;
+            sent[j]       = 1;
+        }
+    }
+    pthread_mutex_unlock(&forks[f[!lo]].mutex);
+    pthread_mutex_unlock(&forks[f[lo]].mutex);
+
+    for (int j = 0; j < 2; j++)
+        if (sent[j])
+            chandy_deliver(peer[j]);
+}
+
+// ============================================================================
+//                                STRATEGY: CAS
 // ----------------------------------------------------------------------------
-// Called by philosopher when done eating 
+// A fork is shared by exactly two philosophers, so at most one can be
+// asleep on it and one wake is always enough.
 // ============================================================================
-void putdown_chopsticks(int i) {
-    
-    pthread_mutex_lock(&mutex);
+static void cas_init(void) {
+    for (int k = 0; k < N; k++)
+        atomic_init(&forks[k].word, 0);
+}
 
-    printf("Philosopher %d has finished eating and is putting down chopsticks...\n", i);
-    state[i] = THINKING;
-    
-    // Notify neighbors
-    test(LEFT(i));
-    test(RIGHT(i));
+static int cas_take(int k) {
+    int free_ = 0;
+    return atomic_compare_exchange_strong_explicit(&forks[k].word, &free_, 1,
+                                                   memory_order_acquire,
+                                                   memory_order_relaxed);
+}
+
+static void cas_drop(int k) {
+    if (atomic_exchange_explicit(&forks[k].word, 0, memory_order_release) == 2)
+        futex_wake_private(&forks[k].word, 1);
+}
+
+// Returns once fork k has been seen free (not necessarily still free)
+static void cas_wait_free(int k) {
+    atomic_int *w = &forks[k].word;
+
+    for (int spin = 0; spin < CAS_SPIN; spin++) {
+        if (atomic_load_explicit(w, memory_order_relaxed) == 0)
+            return;
+        cpu_relax();
+    }
+    int v = atomic_load_explicit(w, memory_order_relaxed);
+    while (v != 0) {
+        // flag ourselves as the sleeper; the holder's exchange sees the 2
+        if (v == 2 || atomic_compare_exchange_weak_explicit(w, &v, 2,
+                                                            memory_order_relaxed,
+                                                            memory_order_relaxed)) {
+            trace_begin("blocked");
+            futex_wait_private(w, 2);
+            trace_end("blocked");
+            v = atomic_load_explicit(w, memory_order_relaxed);
+        }
+    }
+}
+
+static void cas_pickup(int i) {
+    int lo = LFORK(i) < RFORK(i) ? LFORK(i) : RFORK(i);
+    int hi = LFORK(i) ^ RFORK(i) ^ lo;
+
+    for (;;) {
+        if (!cas_take(lo)) {
+            cas_wait_free(lo);
+            continue;
+        }
+        if (cas_take(hi))
+            return;
+        cas_drop(lo);               // don't hold one fork while waiting
+        cas_wait_free(hi);
+    }
+}
 
-    pthread_mutex_unlock(&mutex);
+static void cas_putdown(int i) {
+    cas_drop(LFORK(i));
+    cas_drop(RFORK(i));
 }
 
+// ============================================================================
+//                                 STRATEGIES
+// ============================================================================
+static const strategy_t strategies[] = {
+    { "monitor",   NULL,        monitor_pickup,   monitor_putdown   },
+    { "hierarchy", NULL,        hierarchy_pickup, hierarchy_putdown },
+    { "waiter",    waiter_init, waiter_pickup,    waiter_putdown    },
+    { "chandy",    chandy_init, chandy_pickup,    chandy_putdown    },
+    { "cas",       cas_init,    cas_pickup,       cas_putdown       },
+};
+#define NSTRATEGIES ((int)(sizeof(strategies) / sizeof(strategies[0])))
+
 // ============================================================================
 //                          PHILOSOPHER THREAD FUNCTION
 // ============================================================================
 void* philosopher(void* arg) {
-    int id = *(int*)arg;
-    
-    // Philosopher loop
-    while (1) {
-        printf("Philosopher %d is thinking...\n", id);
+    phil_t *me = arg;
+    int id = me->id;
+
+    trace_thread("%s %d", strategy->name, id);
+
+    // Benchmark loop: spin work instead of sleeps, time every pickup
+    if (quiet) {
+        while (!atomic_load_explicit(&stop, memory_order_relaxed)) {
+            spin_work(think_work);
+
+            long long t0 = now_ns();
+            trace_begin("hungry");
+            strategy->pickup(id);
+            trace_end("hungry");
+            long long waited = now_ns() - t0;
+            me->hist[lat_bucket(waited)]++;
+            if (waited > me->max_wait)
+                me->max_wait = waited;
+
+            me->meals++;
+            trace_begin("eating");
+            spin_work(eat_work);
+            strategy->putdown(id);
+            trace_end("eating");
+        }
+        return NULL;
+    }
+
+    // Philosopher loop (only -T's Ctrl-C sets stop)
+    while (!atomic_load_explicit(&stop, memory_order_relaxed)) {
+        if (!tracing)
+            printf("Philosopher %d is thinking...\n", id);
         sleep(1);               // thinks
-        pickup_chopsticks(id);  // tries to eat
+        if (!tracing)
+            printf("Philosopher %d is hungry and trying to pick up chopsticks...\n", id);
+        trace_begin("hungry");
+        strategy->pickup(id);   // tries to eat
+        trace_end("hungry");
+        if (!tracing)
+            printf("Philosopher %d is eating...\n", id);
+        trace_begin("eating");
         sleep(1);               // eats
-        putdown_chopsticks(id); // done eating
+        if (!tracing)
+            printf("Philosopher %d has finished eating and is putting down chopsticks...\n", id);
+        strategy->putdown(id);  // done eating
+        trace_end("eating");
     }
+    return NULL;
 }
 
 
 // ============================================================================
-//                                     MAIN
+//                                    TABLE
+// ----------------------------------------------------------------------------
+// Sets up N seats, N forks and `ns` stripes for strategy `st`, runs the
+// philosophers (pinned to the
+// first `cpus` CPUs if cpus > 0) for ms milliseconds, or until stop if ms == 0.
 // ============================================================================
-int main() {
-    pthread_t threads[N];
-    int ids[N];
-    
+static result_t run_table(const strategy_t *st, int n, int ns, int cpus, long ms) {
+    N        = n;
+    nstripes = ns;
+    strategy = st;
+    seats    = aligned_alloc(CACHE_LINE, sizeof(seat_t) * N);
+    stripes  = aligned_alloc(CACHE_LINE, sizeof(stripe_t) * nstripes);
+    forks    = aligned_alloc(CACHE_LINE, sizeof(fork_t) * N);
+    phil_t    *phils   = aligned_alloc(CACHE_LINE, sizeof(phil_t) * N);
+    long      *hist    = calloc(LAT_BUCKETS, sizeof(long));
+    pthread_t *threads = malloc(sizeof(pthread_t) * N);
+    if (!seats || !stripes || !forks || !phils || !threads || !hist) {
+        perror("malloc");
+        exit(1);
+    }
+    atomic_store(&stop, false);
+
     // Initialize states
-    for (int i   = 0; i < N; i++) {
-        ids[i]   = i;
-        state[i] = THINKING;
-        pthread_cond_init(&cond[i], NULL);
+    for (int i = 0; i < N; i++) {
+        seats[i].state = THINKING;
+        seats[i].mail  = 0;
+        seats[i].hungry_since = 0;
+        pthread_cond_init(&seats[i].cond, NULL);
+        pthread_mutex_init(&forks[i].mutex, NULL);
+        memset(&phils[i], 0, sizeof(phil_t));
+        phils[i].id = i;
+    }
+    for (int s = 0; s < nstripes; s++)
+        pthread_mutex_init(&stripes[s].mutex, NULL);
+    if (strategy->init)
+        strategy->init();
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, STACK_SIZE);
+    if (cpus > 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int c = 0; c < cpus; c++)
+            CPU_SET(c, &set);
+        pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
     }
 
     // Create philosophers threads
-    for (int i = 0; i < N; i++)
-        pthread_create(&threads[i], NULL, philosopher, &ids[i]);
-    
+    for (int i = 0; i < N; i++) {
+        int rc = pthread_create(&threads[i], &attr, philosopher, &phils[i]);
+        if (rc != 0) {
+            fprintf(stderr, "pthread_create: %s\n", strerror(rc));
+            exit(1);
+        }
+    }
+    pthread_attr_destroy(&attr);
+
+    long long t0 = now_ns();
+    if (ms > 0) {
+        struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+        nanosleep(&ts, NULL);
+        atomic_store(&stop, true);
+    }
+
     // Join threads
     for (int i = 0; i < N; i++)
         pthread_join(threads[i], NULL);
+    double secs = (now_ns() - t0) / 1e9;
 
-    return 0;
+    // Per-seat meals and the merged wait histogram
+    result_t res = { .min_meals = phils[0].meals, .max_meals = phils[0].meals };
+    long   meals  = 0;
+    double sum_sq = 0;
+    for (int i = 0; i < N; i++) {
+        phil_t *p = &phils[i];
+        meals  += p->meals;
+        sum_sq += (double)p->meals * p->meals;
+        if (p->meals < res.min_meals) { res.min_meals = p->meals; res.min_id = i; }
+        if (p->meals > res.max_meals) { res.max_meals = p->meals; res.max_id = i; }
+        if (p->max_wait > res.max_wait)
+            res.max_wait = p->max_wait;
+        for (int b = 0; b < LAT_BUCKETS; b++)
+            hist[b] += p->hist[b];
+        if (verbose)
+            printf("  philosopher %5d  %12ld meals\n", i, p->meals);
+    }
+    res.meals_per_sec = meals / secs;
+    res.jain = sum_sq > 0 ? (double)meals * meals / (N * sum_sq) : 0.0;
+    res.p50  = lat_percentile(hist, meals, 0.50);
+    res.p90  = lat_percentile(hist, meals, 0.90);
+    res.p99  = lat_percentile(hist, meals, 0.99);
+    res.p999 = lat_percentile(hist, meals, 0.999);
+
+    for (int i = 0; i < N; i++) {
+        pthread_cond_destroy(&seats[i].cond);
+        pthread_mutex_destroy(&forks[i].mutex);
+    }
+    for (int s = 0; s < nstripes; s++)
+        pthread_mutex_destroy(&stripes[s].mutex);
+    free(hist);
+    free(threads);
+    free(phils);
+    free(forks);
+    free(stripes);
+    free(seats);
+    return res;
+}
+
+
+// ============================================================================
+//                                     MAIN
+// ----------------------------------------------------------------------------
+// Parses -a into chosen[]; returns how many, or -1 on an unknown name.
+// ============================================================================
+static int parse_strategies(char *arg, const strategy_t *chosen[]) {
+    int k = 0;
+    for (char *tok = strtok(arg, ","); tok; tok = strtok(NULL, ",")) {
+        int found = 0;
+        for (int s = 0; s < NSTRATEGIES; s++) {
+            if (strcmp(tok, "all") == 0 || strcmp(tok, strategies[s].name) == 0) {
+                if (k < NSTRATEGIES)
+                    chosen[k++] = &strategies[s];
+                found = 1;
+            }
+        }
+        if (!found) {
+            fprintf(stderr, "unknown strategy '%s'\n", tok);
+            return -1;
+        }
+    }
+    return k;
+}
+
+static void on_sigint(int sig) {
+    (void)sig;
+    atomic_store(&stop, true);
+}
+
+// Parses -w (microseconds) into ages[] (ns); returns how many, or -1.
+static int parse_ages(char *arg, long long ages[], int max) {
+    int k = 0;
+    for (char *tok = strtok(arg, ","); tok; tok = strtok(NULL, ",")) {
+        if (k == max || atol(tok) < 0) {
+            fprintf(stderr, "-w takes up to %d bounds >= 0\n", max);
+            return -1;
+        }
+        ages[k++] = atol(tok) * 1000LL;
+    }
+    return k;
 }
 
+int main(int argc, char *argv[]) {
+    const strategy_t *chosen[NSTRATEGIES] = { &strategies[0] };
+    long long ages[MAX_AGES] = { 0 };
+    int  nchosen = 1;
+    int  nages   = 1;
+    int  n       = DEFAULT_N;
+    int  ns      = 0;           // 0 = one per seat
+    long ms      = 0;
+    int  sweep   = 0;
+    char *trace  = NULL;
+    int  opt;
+
+    while ((opt = getopt(argc, argv, "a:n:s:w:d:t:e:vCT:")) != -1) {
+        switch (opt) {
+        case 'a':
+            if ((nchosen = parse_strategies(optarg, chosen)) <= 0)
+                return 1;
+            break;
+        case 'w':
+            if ((nages = parse_ages(optarg, ages, MAX_AGES)) <= 0)
+                return 1;
+            break;
+        case 'n': n          = atoi(optarg); break;
+        case 's': ns         = atoi(optarg); break;
+        case 'd': ms         = atol(optarg); break;
+        case 't': think_work = atol(optarg); break;
+        case 'e': eat_work   = atol(optarg); break;
+        case 'v': verbose    = 1;            break;
+        case 'C': sweep      = 1;            break;
+        case 'T': trace      = optarg;       break;
+        default:
+            fprintf(stderr, "usage: %s [-a strategy,...|all] [-n philosophers] [-s stripes] "
+                            "[-w us,...] [-T file] [-d ms [-t think] [-e eat] [-v] [-C]]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (n < 2 || ns < 0 || ms < 0 || think_work < 0 || eat_work < 0) {
+        fprintf(stderr, "need -n >= 2 and no negative values\n");
+        return 1;
+    }
+    if (ns == 0 || ns > n)
+        ns = n;
+
+    if (trace) {
+        if (trace_init(trace, TRACE_EVENTS) == -1) {
+            perror("trace_init");
+            return 1;
+        }
+        tracing = 1;
+    }
+
+    if (ms == 0) {
+        age_ns = ages[0];
+        if (tracing) {
+            signal(SIGINT, on_sigint);
+            fprintf(stderr, "tracing to %s, Ctrl-C to stop\n", trace);
+        }
+        run_table(chosen[0], n, ns, 0, 0);   // without -T it never returns
+        return 0;
+    }
+
+    // One run per strategy, and per aging bound for the monitor. -a may name
+    // the monitor more than once, so every entry can expand to nages runs.
+    struct { const strategy_t *st; long long age; char label[24]; } runs[NSTRATEGIES * MAX_AGES];
+    int nruns = 0;
+    for (int a = 0; a < nchosen; a++) {
+        int monitor = chosen[a]->pickup == monitor_pickup;
+        for (int w = 0; w < (monitor ? nages : 1); w++) {
+            runs[nruns].st  = chosen[a];
+            runs[nruns].age = monitor ? ages[w] : 0;
+            if (monitor && (nages > 1 || ages[w]))
+                snprintf(runs[nruns].label, sizeof(runs[nruns].label), "%s/%lldus",
+                         chosen[a]->name, ages[w] / 1000);
+            else
+                snprintf(runs[nruns].label, sizeof(runs[nruns].label), "%s", chosen[a]->name);
+            nruns++;
+        }
+    }
+
+    quiet = 1;
+    printf("%d philosophers, %ld ms, think %ld / eat %ld spins, monitor stripes %d\n\n",
+           n, ms, think_work, eat_work, ns);
+
+    if (sweep) {
+        verbose = 0;
+        int max_cpus = cpu_count();
+        printf("%6s", "cpus");
+        for (int a = 0; a < nruns; a++)
+            printf(" %14s %10s", runs[a].label, "p99 wait");
+        printf("\n");
+        for (int c = 1; ; c = (c * 2 > max_cpus && c < max_cpus) ? max_cpus : c * 2) {
+            printf("%6d", c);
+            for (int a = 0; a < nruns; a++) {
+                age_ns = runs[a].age;
+                result_t r = run_table(runs[a].st, n, ns, c, ms);
+                printf(" %14.0f %8.1fus", r.meals_per_sec, r.p99 / 1e3);
+            }
+            printf("\n");
+            fflush(stdout);
+            if (c >= max_cpus)
+                break;
+        }
+        return 0;
+    }
+
+    result_t res[NSTRATEGIES * MAX_AGES];
+    for (int a = 0; a < nruns; a++) {
+        if (verbose)
+            printf("%s:\n", runs[a].label);
+        age_ns = runs[a].age;
+        res[a] = run_table(runs[a].st, n, ns, 0, ms);
+    }
+    if (verbose)
+        printf("\n");
+
+    // meals per seat: min / max (and who), Jain's index, min/max;
+    // wait: hungry -> eating
+    printf("%-16s %12s %16s %16s %6s %7s %9s %9s %9s %11s\n", "strategy", "meals/sec",
+           "min seat", "max seat", "jain", "min/max", "p50", "p99", "p99.9", "max wait");
+    for (int a = 0; a < nruns; a++) {
+        result_t *r = &res[a];
+        char lo[32], hi[32];
+        snprintf(lo, sizeof(lo), "%ld #%d", r->min_meals, r->min_id);
+        snprintf(hi, sizeof(hi), "%ld #%d", r->max_meals, r->max_id);
+        printf("%-16s %12.0f %16s %16s %6.3f %7.3f %7.1fus %7.1fus %7.1fus %9.1fus\n",
+               runs[a].label, r->meals_per_sec, lo, hi, r->jain,
+               r->max_meals ? (double)r->min_meals / r->max_meals : 0.0,
+               r->p50 / 1e3, r->p99 / 1e3, r->p999 / 1e3, r->max_wait / 1e3);
+    }
+    return 0;
+}
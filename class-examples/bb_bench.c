@@ -0,0 +1,174 @@
+// bb_bench.c
+//
+// Blocking bounded buffer (../common/bounded_buffer.h): throughput by batch
+// size, and how often producers / consumers spun versus parked.
+// -------------------------------------------------------
+// Build:
+//   gcc -O2 -pthread bb_bench.c -o bb_bench
+//
+// Run:
+//   ./bb_bench [-n items] [-c capacity] [-p producers] [-k consumers] [-s]
+//
+//   -s   spin before parking even on a single CPU (normally switched off
+//        there), to see what it costs
+//
+// Every item 1..n is put once and got once; the consumers' sum is checked.
+
+#define _GNU_SOURCE   // pthread_barrier
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define BB_T        long
+#define BB_NAME(x)  long_bb_##x
+#include "../common/bounded_buffer.h"
+
+// ============================================================================
+//                                CONFIGURATION
+// ============================================================================
+#define DEFAULT_ITEMS  4000000L
+#define DEFAULT_CAP    1024
+#define MAX_BATCH      256
+
+typedef struct {
+    long_bb_t         buf;
+    size_t            batch;
+    pthread_barrier_t start;
+} bench_t;
+
+typedef struct {
+    bench_t *b;
+    long     first, count;   // producer: values first..first+count-1
+    long     sum;            // consumer: sum of what it got
+} CACHE_ALIGNED worker_t;
+
+// ============================================================================
+//                                   THREADS
+// ============================================================================
+static void *producer(void *arg) {
+    worker_t *w = arg;
+    bench_t  *b = w->b;
+    long      items[MAX_BATCH];
+
+    pthread_barrier_wait(&b->start);
+    for (long v = w->first; v < w->first + w->count; ) {
+        size_t n = 0;
+        while (n < b->batch && v < w->first + w->count)
+            items[n++] = v++;
+        long_bb_put_many(&b->buf, items, n);
+    }
+    return NULL;
+}
+
+static void *consumer(void *arg) {
+    worker_t *w = arg;
+    bench_t  *b = w->b;
+    long      items[MAX_BATCH];
+    long      sum = 0;
+
+    pthread_barrier_wait(&b->start);
+    for (long left = w->count; left > 0; ) {
+        size_t max = b->batch < (size_t)left ? b->batch : (size_t)left;
+        size_t n   = long_bb_get_many(&b->buf, items, max);
+        for (size_t i = 0; i < n; i++)
+            sum += items[i];
+        left -= (long)n;
+    }
+    w->sum = sum;
+    return NULL;
+}
+
+// ============================================================================
+//                                  ONE RUN
+// ============================================================================
+static void run(long items, size_t cap, int np, int nc, size_t batch, int force_spin) {
+    bench_t *b = aligned_alloc(CACHE_LINE, sizeof(bench_t));
+    if (long_bb_init(&b->buf, cap) == -1) {
+        perror("long_bb_init");
+        exit(1);
+    }
+    if (force_spin)
+        b->buf.spin_ok = 1;
+    b->batch = batch;
+    pthread_barrier_init(&b->start, NULL, np + nc + 1);
+
+    int        n  = np + nc;
+    pthread_t *th = malloc(sizeof(pthread_t) * n);
+    worker_t  *ws = aligned_alloc(CACHE_LINE, sizeof(worker_t) * n);
+
+    long next = 1;
+    for (int i = 0; i < np; i++) {
+        long share = items / np + (i < items % np);
+        ws[i] = (worker_t){ b, next, share, 0 };
+        next += share;
+    }
+    for (int j = 0; j < nc; j++)
+        ws[np + j] = (worker_t){ b, 0, items / nc + (j < items % nc), 0 };
+
+    for (int i = 0; i < n; i++)
+        pthread_create(&th[i], NULL, i < np ? producer : consumer, &ws[i]);
+
+    long long t0 = now_ns();
+    pthread_barrier_wait(&b->start);
+    for (int i = 0; i < n; i++)
+        pthread_join(th[i], NULL);
+    double secs = (now_ns() - t0) / 1e9;
+
+    long sum = 0;
+    for (int j = 0; j < nc; j++)
+        sum += ws[np + j].sum;
+    if (sum != items * (items + 1) / 2)
+        fprintf(stderr, "warning: checksum %ld, expected %ld\n", sum, items * (items + 1) / 2);
+
+    printf("%6zu %10.2f %10ld %10ld %10ld %10ld\n", batch, items / secs / 1e6,
+           atomic_load(&b->buf.put_side.spins), atomic_load(&b->buf.put_side.parks),
+           atomic_load(&b->buf.get_side.spins), atomic_load(&b->buf.get_side.parks));
+    fflush(stdout);
+
+    free(ws);
+    free(th);
+    pthread_barrier_destroy(&b->start);
+    long_bb_destroy(&b->buf);
+    free(b);
+}
+
+// ============================================================================
+//                                     MAIN
+// ============================================================================
+int main(int argc, char *argv[]) {
+    long   items      = DEFAULT_ITEMS;
+    size_t cap        = DEFAULT_CAP;
+    int    np         = 1;
+    int    nc         = 1;
+    int    force_spin = 0;
+    int    opt;
+
+    while ((opt = getopt(argc, argv, "n:c:p:k:s")) != -1) {
+        switch (opt) {
+        case 'n': items      = atol(optarg);          break;
+        case 'c': cap        = (size_t)atol(optarg);  break;
+        case 'p': np         = atoi(optarg);          break;
+        case 'k': nc         = atoi(optarg);          break;
+        case 's': force_spin = 1;                     break;
+        default:
+            fprintf(stderr, "usage: %s [-n items] [-c capacity] [-p producers] [-k consumers] [-s]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (items < 1 || cap < 1 || np < 1 || nc < 1) {
+        fprintf(stderr, "bad -n / -c / -p / -k\n");
+        return 1;
+    }
+
+    printf("%ld items, capacity %zu, %d producer(s), %d consumer(s), spinning %s\n\n",
+           items, cap, np, nc, (force_spin || cpu_count() > 1) ? "on" : "off (1 CPU)");
+    printf("%6s %10s %10s %10s %10s %10s\n",
+           "batch", "Mitems/s", "put spin", "put park", "get spin", "get park");
+
+    static const size_t batches[] = { 1, 16, 64, MAX_BATCH };
+    for (size_t i = 0; i < sizeof(batches) / sizeof(batches[0]); i++)
+        run(items, cap, np, nc, batches[i], force_spin);
+    return 0;
+}
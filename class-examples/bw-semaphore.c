@@ -1,21 +1,86 @@
-#include "stdlib.h"
-#include "stdio.h"
-#include "pthread.h"
-#include "semaphore.h"
+// bw-semaphore.c
+//
+// Busy-wait semaphore.
+// -------------------------------------------------------
+// Build:
+//   gcc -pthread bw-semaphore.c -o bw-semaphore
+//
+// The spinning counterparts for plain locks (test-and-set, ticket, MCS, ...)
+// live in ../as3-sync/locks.h.
 
-int main(int argc, char *argv[]) {
-    printf("Hello Semaphores!\n");
-    
-    // wait
-    sem_lock(s){
-        while (s <= 0) ; // busy wait
-        s--;
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "../common/bench.h"
+
+#define THREAD_COUNT 4
+#define RESOURCES    2
+#define ITERATIONS   100000
+
+typedef struct {
+    atomic_int s;   // resources available
+} bw_semaphore;
+
+// wait
+//   while (s <= 0) ; // busy wait
+//   s--;
+// The check and the decrement must be one atomic step, or two threads can
+// both see s == 1 and both take it; compare-and-swap does that.
+void bw_wait(bw_semaphore *sem) {
+    for (;;) {
+        int s = atomic_load_explicit(&sem->s, memory_order_relaxed);
+        if (s > 0 &&
+            atomic_compare_exchange_weak_explicit(&sem->s, &s, s - 1,
+                                                  memory_order_acquire,
+                                                  memory_order_relaxed))
+            return;
+        cpu_relax();    // busy wait
     }
+}
+
+// signal
+//   s++;
+void bw_signal(bw_semaphore *sem) {
+    atomic_fetch_add_explicit(&sem->s, 1, memory_order_release);
+}
+
+bw_semaphore sem;
+atomic_int   inside;      // threads currently holding a resource
+atomic_int   max_inside;  // most ever seen at once (must stay <= RESOURCES)
 
-    signal(s){
-        s++;
+void* worker(void* arg) {
+    (void)arg;
+    for (int i = 0; i < ITERATIONS; i++) {
+        bw_wait(&sem);
+        int now = atomic_fetch_add(&inside, 1) + 1;
+        int max = atomic_load_explicit(&max_inside, memory_order_relaxed);
+        while (now > max &&
+               !atomic_compare_exchange_weak_explicit(&max_inside, &max, now,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+            ;   // max reloaded by the failed CAS
+        atomic_fetch_sub(&inside, 1);
+        bw_signal(&sem);
     }
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    (void)argc;
+    (void)argv;
+    printf("Hello Semaphores!\n");
+
+    atomic_init(&sem.s, RESOURCES);
+
+    pthread_t threads[THREAD_COUNT];
+    for (int i = 0; i < THREAD_COUNT; i++)
+        pthread_create(&threads[i], NULL, worker, NULL);
+    for (int i = 0; i < THREAD_COUNT; i++)
+        pthread_join(threads[i], NULL);
 
+    printf("max holders at once: %d (limit %d)\n", atomic_load(&max_inside), RESOURCES);
     return 0;
 }
 
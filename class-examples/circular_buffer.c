@@ -1,98 +1,119 @@
+// circular_buffer.c
+//
+// Build:
+//   gcc circular_buffer.c -o circular_buffer
+//
+// Throughput benchmark (producer and consumer threads):
+//   gcc -O2 -pthread ring_bench.c -o ring_bench
+//
+// This demo just reports full/empty. For a buffer that makes producers and
+// consumers wait (condvars, batches, spin-then-park) see
+// ../common/bounded_buffer.h and bb_bench.c.
+//
+// The buffer is the SPSC ring from ../common/spsc_ring.h. Items are stored
+// inline in the slots, so produce and consume do no allocation. The head and
+// tail indices are free-running counters masked into a power-of-two array.
+// The same ring works unchanged with the producer and consumer in different
+// threads.
+
+#define _POSIX_C_SOURCE 200809L   // clock_gettime in ../common/bench.h
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define BUFFER_SIZE 10
+typedef struct { int index; } item;
 
-int main(int argc, char argv[]){
+#define RING_T        item
+#define RING_NAME(x)  item_ring_##x
+#include "../common/spsc_ring.h"
 
-    typedef struct { int index;} item; // Anon-Struct
+// spsc_ring.h needs a power-of-two capacity (the index is a mask, not a
+// modulo) and rounds anything else up: a size of 10 would silently give a
+// 16-slot ring. 8 is the nearest power of two that keeps the demo small.
+#define BUFFER_SIZE 8
 
-    item* buffer[BUFFER_SIZE] = {NULL};
-    int counter = 0;
-    int in      = 0;
-    int out     = 0;
-    char header[100] = " --- Welcome to my Circular Buffer ---";
-    
-    int get_next(int index, int size){
-        if (index+1 < size){
-            return index+1;
-        } else {
-            return 0;
-        }
+static item_ring_t buffer;
+static int         produced = 0;   // running item number
+
+// Producer Function
+static const char* produce(item_ring_t *r){
+
+    static char buf1[100];
+
+    item new_item = { produced };
+    if (item_ring_push(r, &new_item)) {
+        produced++;
+        sprintf(buf1, "Produced index: %d", new_item.index);
+    } else {
+        sprintf(buf1, "Cannot produce.(Buffer is full)");
     }
+    return buf1;
+}
+
+// Consumer Function
+static const char* consume(item_ring_t *r){
 
-    // Producer Function
-    const char* produce(item **arr, int size, int *in){
-            
-        static char buf1[100];
+    static char buf2[100];
+
+    item old_item;
+    if (item_ring_pop(r, &old_item)) {
+        sprintf(buf2,"Consumed index: %d", old_item.index);
+    } else {
+        sprintf(buf2, "Nothing to consume.(Buffer is empty)");
+    }
+    return buf2;
+}
 
-        if (arr[*in] == NULL) {
-            item *new_item = malloc(sizeof(item));
-            new_item->index = *in;
-            arr[*in]    = new_item;
-            *in = get_next(*in, size);
+// Draw Buffer Function
+// Slot i is filled if it lies between head (next to consume) and tail
+// (next to produce), counting round the ring.
+static void draw_buffer(item_ring_t *r){
+    size_t head = atomic_load(&r->head) & r->mask;
+    size_t used = item_ring_size(r);
 
-            sprintf(buf1, "Produced index: %d", new_item->index);
-        
+    for (size_t i = 0; i <= r->mask; i++){
+        if (((i - head) & r->mask) < used){
+            printf("[*]");
         } else {
-            sprintf(buf1, "Cannot produce.(Buffer is full)");
+            printf("[ ]");
         }
-        return buf1;
-    }   
-
-    // Consumer Function
-    const char* consume(item **arr, int size, int *out){
-
-        static char buf2[100];
-        
-        if (arr[*out] != NULL) {
-            item *old_item = arr[*out];
-            arr[*out] = NULL;
-            sprintf(buf2,"Consumed index: %d", old_item->index);
-            *out = get_next(*out, size);
-            free(old_item);
-        } else {
-            sprintf(buf2, "Nothing to consume.(Buffer is empty)");
-        } 
-        return buf2;
     }
+}
 
-    // Draw Buffer Function
-    void draw_buffer(item **arr, int size){
-        for (int i = 0; i < size; i++){
-            if ( arr[i] == NULL){
-                printf("[ ]");
-            } else {
-                printf("[*]");
-            }
-        }
+int main(void){
+
+    char header[100] = " --- Welcome to my Circular Buffer ---";
+
+    if (item_ring_init(&buffer, BUFFER_SIZE) == -1) {
+        perror("item_ring_init");
+        return 1;
     }
-    
+
     char input[10] = "r";
 
     // Main Loop
     while (strcmp(input, "x") != 0){
-        
+
         system("clear");
         printf("%s\n\n", header);
-        draw_buffer(buffer, BUFFER_SIZE);
+        draw_buffer(&buffer);
         strcpy(input, "r");
         printf("\n\n\t[c] Consume\n\t[p] Produce\n\t[x] Exit\n");
         printf("\t: ");
-        scanf("%s", input);
+        if (scanf("%9s", input) != 1)
+            break;
 
         // Produce Action
         if (strcmp(input, "p") == 0) {
-            strcpy(header, produce(buffer, BUFFER_SIZE, &in));
+            strcpy(header, produce(&buffer));
 
         // Consume Action
         } else if (strcmp(input, "c") == 0) {
-            strcpy(header, consume(buffer, BUFFER_SIZE, &out));
+            strcpy(header, consume(&buffer));
         }
     }
 
+    item_ring_destroy(&buffer);
     return 0;
 }
-
-
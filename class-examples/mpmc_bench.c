@@ -0,0 +1,254 @@
+// mpmc_bench.c
+//
+// Bounded MPMC queue (../common/mpmc_queue.h) vs a mutex + condvar bounded
+// buffer, sweeping the number of producers and consumers.
+// -------------------------------------------------------
+// Build:
+//   gcc -O2 -pthread mpmc_bench.c -o mpmc_bench
+//
+// Run:
+//   ./mpmc_bench [-n items] [-c capacity] [-t max_threads_per_side]
+//
+// Every producer pushes its share of 1..items, every consumer pops until all
+// items are gone; the sum of everything popped must match.
+//
+//   condvar   one mutex, not_full / not_empty condition variables: the
+//             classic bounded buffer; waiters sleep in the kernel
+//   mpmc      lock-free; a side that finds the queue full/empty spins briefly
+//             and then yields
+
+#define _GNU_SOURCE   // sched_yield, pthread_barrier
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define QUEUE_T        long
+#define QUEUE_NAME(x)  long_queue_##x
+#include "../common/mpmc_queue.h"
+
+// ============================================================================
+//                                CONFIGURATION
+// ============================================================================
+#define DEFAULT_ITEMS  4000000L
+#define DEFAULT_CAP    1024
+#define SPINS          64       // full/empty checks before sched_yield
+
+// ============================================================================
+//                          MUTEX + CONDVAR BASELINE
+// ============================================================================
+typedef struct {
+    long           *items;
+    size_t          cap, in, out, count;
+    pthread_mutex_t lock;
+    pthread_cond_t  not_full, not_empty;
+} cond_buf_t;
+
+static void cond_buf_init(cond_buf_t *b, size_t cap) {
+    b->items = malloc(sizeof(long) * cap);
+    b->cap   = cap;
+    b->in = b->out = b->count = 0;
+    pthread_mutex_init(&b->lock, NULL);
+    pthread_cond_init(&b->not_full, NULL);
+    pthread_cond_init(&b->not_empty, NULL);
+}
+
+static void cond_buf_destroy(cond_buf_t *b) {
+    pthread_cond_destroy(&b->not_empty);
+    pthread_cond_destroy(&b->not_full);
+    pthread_mutex_destroy(&b->lock);
+    free(b->items);
+}
+
+static void cond_buf_put(cond_buf_t *b, long v) {
+    pthread_mutex_lock(&b->lock);
+    while (b->count == b->cap)
+        pthread_cond_wait(&b->not_full, &b->lock);
+    b->items[b->in] = v;
+    b->in = (b->in + 1) % b->cap;
+    b->count++;
+    pthread_cond_signal(&b->not_empty);
+    pthread_mutex_unlock(&b->lock);
+}
+
+static long cond_buf_get(cond_buf_t *b) {
+    pthread_mutex_lock(&b->lock);
+    while (b->count == 0)
+        pthread_cond_wait(&b->not_empty, &b->lock);
+    long v = b->items[b->out];
+    b->out = (b->out + 1) % b->cap;
+    b->count--;
+    pthread_cond_signal(&b->not_full);
+    pthread_mutex_unlock(&b->lock);
+    return v;
+}
+
+// ============================================================================
+//                                  BENCH STATE
+// ============================================================================
+typedef enum { V_COND, V_MPMC } variant_t;
+
+typedef struct {
+    variant_t         variant;
+    long_queue_t      queue;
+    cond_buf_t        cbuf;
+    pthread_barrier_t start;
+} bench_t;
+
+typedef struct {
+    bench_t *b;
+    long     first, count;   // producer: values first..first+count-1
+    long     sum;            // consumer: sum of what it popped
+} CACHE_ALIGNED worker_t;
+
+static void backoff(int *spins) {
+    if (++*spins < SPINS) {
+        cpu_relax();
+    } else {
+        *spins = 0;
+        sched_yield();
+    }
+}
+
+// ============================================================================
+//                                   THREADS
+// ============================================================================
+static void *producer(void *arg) {
+    worker_t *w = arg;
+    bench_t  *b = w->b;
+    int spins = 0;
+
+    pthread_barrier_wait(&b->start);
+    for (long v = w->first; v < w->first + w->count; ) {
+        if (b->variant == V_COND) {
+            cond_buf_put(&b->cbuf, v++);
+        } else if (long_queue_push(&b->queue, &v)) {
+            v++;
+            spins = 0;
+        } else {
+            backoff(&spins);
+        }
+    }
+    return NULL;
+}
+
+static void *consumer(void *arg) {
+    worker_t *w = arg;
+    bench_t  *b = w->b;
+    int spins = 0;
+    long sum = 0;
+
+    pthread_barrier_wait(&b->start);
+    for (long i = 0; i < w->count; ) {
+        long v;
+        if (b->variant == V_COND) {
+            sum += cond_buf_get(&b->cbuf);
+            i++;
+        } else if (long_queue_pop(&b->queue, &v)) {
+            sum += v;
+            i++;
+            spins = 0;
+        } else {
+            backoff(&spins);
+        }
+    }
+    w->sum = sum;
+    return NULL;
+}
+
+// ============================================================================
+//                                  ONE RUN
+// ----------------------------------------------------------------------------
+// Items are split evenly: producer i pushes its block, consumer j pops its
+// share (whatever producer it comes from). Returns Mitems/s.
+// ============================================================================
+static double run(variant_t v, int np, int nc, long items, size_t cap) {
+    bench_t *b = aligned_alloc(CACHE_LINE, sizeof(bench_t));
+    b->variant = v;
+    if (long_queue_init(&b->queue, cap) == -1) {
+        perror("long_queue_init");
+        exit(1);
+    }
+    cond_buf_init(&b->cbuf, cap);
+    pthread_barrier_init(&b->start, NULL, np + nc + 1);
+
+    int        n  = np + nc;
+    pthread_t *th = malloc(sizeof(pthread_t) * n);
+    worker_t  *ws = aligned_alloc(CACHE_LINE, sizeof(worker_t) * n);
+
+    long next = 1;
+    for (int i = 0; i < np; i++) {
+        long share = items / np + (i < items % np);
+        ws[i] = (worker_t){ b, next, share, 0 };
+        next += share;
+    }
+    for (int j = 0; j < nc; j++)
+        ws[np + j] = (worker_t){ b, 0, items / nc + (j < items % nc), 0 };
+
+    for (int i = 0; i < n; i++)
+        pthread_create(&th[i], NULL, i < np ? producer : consumer, &ws[i]);
+
+    long long t0 = now_ns();
+    pthread_barrier_wait(&b->start);
+    for (int i = 0; i < n; i++)
+        pthread_join(th[i], NULL);
+    double secs = (now_ns() - t0) / 1e9;
+
+    long sum = 0;
+    for (int j = 0; j < nc; j++)
+        sum += ws[np + j].sum;
+    if (sum != items * (items + 1) / 2)
+        fprintf(stderr, "warning: checksum %ld, expected %ld\n", sum, items * (items + 1) / 2);
+
+    free(ws);
+    free(th);
+    pthread_barrier_destroy(&b->start);
+    cond_buf_destroy(&b->cbuf);
+    long_queue_destroy(&b->queue);
+    free(b);
+    return items / secs / 1e6;
+}
+
+// ============================================================================
+//                                     MAIN
+// ============================================================================
+int main(int argc, char *argv[]) {
+    long   items       = DEFAULT_ITEMS;
+    size_t cap         = DEFAULT_CAP;
+    int    max_threads = cpu_count() > 1 ? cpu_count() / 2 : 1;
+    int    opt;
+
+    while ((opt = getopt(argc, argv, "n:c:t:")) != -1) {
+        switch (opt) {
+        case 'n': items       = atol(optarg);          break;
+        case 'c': cap         = (size_t)atol(optarg);  break;
+        case 't': max_threads = atoi(optarg);          break;
+        default:
+            fprintf(stderr, "usage: %s [-n items] [-c capacity] [-t max_threads_per_side]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (items < 1 || cap < 2 || max_threads < 1) {
+        fprintf(stderr, "bad -n / -c / -t\n");
+        return 1;
+    }
+
+    printf("%ld items, capacity %zu (Mitems/s)\n\n", items, cap);
+    printf("%5s %5s %10s %10s\n", "prod", "cons", "condvar", "mpmc");
+
+    for (int p = 1; ; p = (p * 2 > max_threads && p < max_threads) ? max_threads : p * 2) {
+        for (int c = 1; ; c = (c * 2 > max_threads && c < max_threads) ? max_threads : c * 2) {
+            double cv = run(V_COND, p, c, items, cap);
+            double lf = run(V_MPMC, p, c, items, cap);
+            printf("%5d %5d %10.2f %10.2f\n", p, c, cv, lf);
+            fflush(stdout);
+            if (c >= max_threads)
+                break;
+        }
+        if (p >= max_threads)
+            break;
+    }
+    return 0;
+}
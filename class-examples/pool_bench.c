@@ -0,0 +1,244 @@
+// pool_bench.c
+//
+// Object pool (../common/obj_pool.h) vs glibc malloc/free when objects are
+// allocated on one thread and freed on another.
+// -------------------------------------------------------
+// Build:
+//   gcc -O2 -pthread pool_bench.c -o pool_bench
+//
+// Run:
+//   ./pool_bench [-n objects_per_pair] [-s object_size] [-t max_pairs]
+//
+// Each pair is a producer that allocates an object, writes into it and
+// passes the pointer through an SPSC ring (../common/spsc_ring.h), and a
+// consumer that reads it and frees it - the circular_buffer.c pattern, but
+// with the item behind a pointer. Pairs double up to max_pairs.
+
+#define _GNU_SOURCE   // sched_yield, pthread_barrier
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../common/obj_pool.h"
+
+#define RING_T        void *
+#define RING_NAME(x)  ptr_ring_##x
+#include "../common/spsc_ring.h"
+
+// ============================================================================
+//                                CONFIGURATION
+// ============================================================================
+#define DEFAULT_OBJS   2000000L
+#define DEFAULT_SIZE   64
+#define RING_CAP       1024
+#define BATCH          32
+#define SPINS          64       // full/empty checks before sched_yield
+
+typedef enum { V_MALLOC, V_POOL } variant_t;
+
+typedef struct {
+    variant_t         variant;
+    size_t            obj_size;
+    long              objs;
+    obj_pool_t        pool;
+    pthread_barrier_t start;
+} bench_t;
+
+typedef struct {
+    bench_t    *b;
+    ptr_ring_t  ring;       // producer -> consumer of this pair
+    long        errors;
+} pair_t;
+
+typedef struct {
+    pair_t *pair;
+    int     producer;
+} CACHE_ALIGNED worker_t;
+
+static void backoff(int *spins) {
+    if (++*spins < SPINS) {
+        cpu_relax();
+    } else {
+        *spins = 0;
+        sched_yield();
+    }
+}
+
+// ============================================================================
+//                                   THREADS
+// ============================================================================
+static void *producer(bench_t *b, pair_t *pr) {
+    obj_cache_t cache = { NULL, NULL };
+    void       *batch[BATCH];
+    int         spins = 0;
+
+    if (b->variant == V_POOL)
+        obj_cache_init(&b->pool, &cache);
+
+    pthread_barrier_wait(&b->start);
+    for (long i = 0; i < b->objs; ) {
+        size_t n = 0;
+        while (n < BATCH && i < b->objs) {
+            long *obj = b->variant == V_POOL ? obj_alloc(&b->pool, &cache)
+                                             : malloc(b->obj_size);
+            if (!obj) {
+                // pool drained into the consumers' caches; wait for frees
+                backoff(&spins);
+                break;
+            }
+            obj[0] = i++;
+            batch[n++] = obj;
+        }
+        for (size_t done = 0; done < n; ) {
+            size_t k = ptr_ring_push_n(&pr->ring, batch + done, n - done);
+            if (k == 0)
+                backoff(&spins);
+            done += k;
+        }
+    }
+
+    if (b->variant == V_POOL)
+        obj_cache_destroy(&b->pool, &cache);
+    return NULL;
+}
+
+static void *consumer(bench_t *b, pair_t *pr) {
+    obj_cache_t cache = { NULL, NULL };
+    void       *batch[BATCH];
+    int         spins = 0;
+    long        expect = 0;
+
+    if (b->variant == V_POOL)
+        obj_cache_init(&b->pool, &cache);
+
+    pthread_barrier_wait(&b->start);
+    while (expect < b->objs) {
+        size_t n = ptr_ring_pop_n(&pr->ring, batch, BATCH);
+        if (n == 0) {
+            backoff(&spins);
+            continue;
+        }
+        for (size_t k = 0; k < n; k++) {
+            long *obj = batch[k];
+            if (obj[0] != expect++)
+                pr->errors++;
+            if (b->variant == V_POOL)
+                obj_free(&b->pool, &cache, obj);
+            else
+                free(obj);
+        }
+    }
+
+    if (b->variant == V_POOL)
+        obj_cache_destroy(&b->pool, &cache);
+    return NULL;
+}
+
+static void *worker(void *arg) {
+    worker_t *w = arg;
+    return w->producer ? producer(w->pair->b, w->pair) : consumer(w->pair->b, w->pair);
+}
+
+// ============================================================================
+//                                  ONE RUN
+// ----------------------------------------------------------------------------
+// Returns millions of alloc+free pairs per second.
+// ============================================================================
+static double run(variant_t v, int pairs, long objs, size_t obj_size) {
+    bench_t *b = aligned_alloc(CACHE_LINE, sizeof(bench_t));
+    b->variant  = v;
+    b->obj_size = obj_size;
+    b->objs     = objs;
+
+    // enough for every ring to be full plus every cache's two magazines
+    size_t capacity = (size_t)pairs * (RING_CAP + BATCH + 4 * OBJ_MAG_SIZE);
+    if (v == V_POOL && obj_pool_init(&b->pool, obj_size, capacity, 2 * pairs) == -1) {
+        perror("obj_pool_init");
+        exit(1);
+    }
+    pthread_barrier_init(&b->start, NULL, 2 * pairs + 1);
+
+    pair_t    *prs = aligned_alloc(CACHE_LINE, sizeof(pair_t) * pairs);
+    worker_t  *ws  = aligned_alloc(CACHE_LINE, sizeof(worker_t) * 2 * pairs);
+    pthread_t *th  = malloc(sizeof(pthread_t) * 2 * pairs);
+
+    for (int i = 0; i < pairs; i++) {
+        prs[i].b      = b;
+        prs[i].errors = 0;
+        if (ptr_ring_init(&prs[i].ring, RING_CAP) == -1) {
+            perror("ptr_ring_init");
+            exit(1);
+        }
+    }
+    for (int i = 0; i < 2 * pairs; i++) {
+        ws[i].pair     = &prs[i / 2];
+        ws[i].producer = i % 2 == 0;
+        pthread_create(&th[i], NULL, worker, &ws[i]);
+    }
+
+    long long t0 = now_ns();
+    pthread_barrier_wait(&b->start);
+    for (int i = 0; i < 2 * pairs; i++)
+        pthread_join(th[i], NULL);
+    double secs = (now_ns() - t0) / 1e9;
+
+    long errors = 0;
+    for (int i = 0; i < pairs; i++) {
+        errors += prs[i].errors;
+        ptr_ring_destroy(&prs[i].ring);
+    }
+    if (errors)
+        fprintf(stderr, "warning: %ld objects out of order or corrupted\n", errors);
+
+    if (v == V_POOL)
+        obj_pool_destroy(&b->pool);
+    pthread_barrier_destroy(&b->start);
+    free(th);
+    free(ws);
+    free(prs);
+    free(b);
+    return (double)objs * pairs / secs / 1e6;
+}
+
+// ============================================================================
+//                                     MAIN
+// ============================================================================
+int main(int argc, char *argv[]) {
+    long   objs      = DEFAULT_OBJS;
+    size_t obj_size  = DEFAULT_SIZE;
+    int    max_pairs = cpu_count() > 1 ? cpu_count() / 2 : 1;
+    int    opt;
+
+    while ((opt = getopt(argc, argv, "n:s:t:")) != -1) {
+        switch (opt) {
+        case 'n': objs      = atol(optarg);          break;
+        case 's': obj_size  = (size_t)atol(optarg);  break;
+        case 't': max_pairs = atoi(optarg);          break;
+        default:
+            fprintf(stderr, "usage: %s [-n objects_per_pair] [-s object_size] [-t max_pairs]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (objs < 1 || obj_size < sizeof(long) || max_pairs < 1) {
+        fprintf(stderr, "bad -n / -s / -t\n");
+        return 1;
+    }
+
+    printf("%ld objects of %zu bytes per pair, allocated by the producer and\n"
+           "freed by the consumer (M objects/s)\n\n", objs, obj_size);
+    printf("%6s %10s %10s\n", "pairs", "malloc", "pool");
+
+    for (int t = 1; ; t = (t * 2 > max_pairs && t < max_pairs) ? max_pairs : t * 2) {
+        double m = run(V_MALLOC, t, objs, obj_size);
+        double p = run(V_POOL, t, objs, obj_size);
+        printf("%6d %10.2f %10.2f\n", t, m, p);
+        fflush(stdout);
+        if (t >= max_pairs)
+            break;
+    }
+    return 0;
+}
@@ -0,0 +1,264 @@
+// ring_bench.c
+//
+// SPSC ring (../common/spsc_ring.h) throughput, one producer thread and one
+// consumer thread.
+// -------------------------------------------------------
+// Build:
+//   gcc -O2 -pthread ring_bench.c -o ring_bench
+//
+// Run:
+//   ./ring_bench [-n items] [-c capacity]
+//
+// Rows:
+//   malloc+mutex   the old circular_buffer.c scheme: a pointer per slot,
+//                  malloc() per item, free() on consume, a mutex around it
+//                  (always DEFAULT_CAP slots)
+//   spsc           push / pop one item at a time
+//   spsc batch B   push_n / pop_n up to B items per call
+//
+// The consumer checks every item arrives, in order. A side that finds the
+// ring full/empty spins briefly and then yields (needed when both threads
+// share one CPU).
+
+#define _GNU_SOURCE   // sched_yield, pthread_barrier
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define RING_T        long
+#define RING_NAME(x)  long_ring_##x
+#include "../common/spsc_ring.h"
+
+// ============================================================================
+//                                CONFIGURATION
+// ============================================================================
+#define DEFAULT_ITEMS  50000000L
+#define DEFAULT_CAP    4096
+#define MAX_BATCH      256
+#define SPINS          64       // full/empty checks before sched_yield
+
+typedef struct {
+    long           *slots[DEFAULT_CAP];
+    size_t          in, out, count;
+    pthread_mutex_t lock;
+} mutex_buf_t;
+
+typedef struct {
+    long_ring_t       ring;
+    mutex_buf_t      *mbuf;
+    long              items;
+    size_t            batch;    // 0 = malloc+mutex row
+    long              errors;
+    pthread_barrier_t start;
+} bench_t;
+
+static void backoff(int *spins) {
+    if (++*spins < SPINS) {
+        cpu_relax();
+    } else {
+        *spins = 0;
+        sched_yield();
+    }
+}
+
+// ============================================================================
+//                           MALLOC + MUTEX BASELINE
+// ============================================================================
+static void *mutex_producer(void *arg) {
+    bench_t     *b = arg;
+    mutex_buf_t *m = b->mbuf;
+    int spins = 0;
+
+    pthread_barrier_wait(&b->start);
+    for (long i = 0; i < b->items; ) {
+        pthread_mutex_lock(&m->lock);
+        if (m->count < DEFAULT_CAP) {
+            long *p = malloc(sizeof(long));
+            *p = i++;
+            m->slots[m->in] = p;
+            m->in = (m->in + 1) % DEFAULT_CAP;
+            m->count++;
+            pthread_mutex_unlock(&m->lock);
+        } else {
+            pthread_mutex_unlock(&m->lock);
+            backoff(&spins);
+        }
+    }
+    return NULL;
+}
+
+static void *mutex_consumer(void *arg) {
+    bench_t     *b = arg;
+    mutex_buf_t *m = b->mbuf;
+    int spins = 0;
+
+    pthread_barrier_wait(&b->start);
+    for (long expect = 0; expect < b->items; ) {
+        long *p = NULL;
+        pthread_mutex_lock(&m->lock);
+        if (m->count > 0) {
+            p = m->slots[m->out];
+            m->out = (m->out + 1) % DEFAULT_CAP;
+            m->count--;
+        }
+        pthread_mutex_unlock(&m->lock);
+
+        if (!p) {
+            backoff(&spins);
+            continue;
+        }
+        if (*p != expect++)
+            b->errors++;
+        free(p);
+    }
+    return NULL;
+}
+
+// ============================================================================
+//                                 SPSC RING
+// ============================================================================
+static void *ring_producer(void *arg) {
+    bench_t *b = arg;
+    long     buf[MAX_BATCH];
+    int      spins = 0;
+
+    pthread_barrier_wait(&b->start);
+    if (b->batch == 1) {
+        for (long i = 0; i < b->items; ) {
+            if (long_ring_push(&b->ring, &i))
+                i++;
+            else
+                backoff(&spins);
+        }
+        return NULL;
+    }
+
+    long next = 0;
+    while (next < b->items) {
+        size_t n = b->batch;
+        if ((long)n > b->items - next)
+            n = (size_t)(b->items - next);
+        for (size_t k = 0; k < n; k++)
+            buf[k] = next + (long)k;
+
+        size_t done = 0;
+        while (done < n) {
+            size_t got = long_ring_push_n(&b->ring, buf + done, n - done);
+            if (got == 0)
+                backoff(&spins);
+            done += got;
+        }
+        next += (long)n;
+    }
+    return NULL;
+}
+
+static void *ring_consumer(void *arg) {
+    bench_t *b = arg;
+    long     buf[MAX_BATCH];
+    int      spins = 0;
+    long     expect = 0;
+
+    pthread_barrier_wait(&b->start);
+    while (expect < b->items) {
+        size_t n;
+        if (b->batch == 1)
+            n = long_ring_pop(&b->ring, buf);
+        else
+            n = long_ring_pop_n(&b->ring, buf, b->batch);
+        if (n == 0) {
+            backoff(&spins);
+            continue;
+        }
+        for (size_t k = 0; k < n; k++)
+            if (buf[k] != expect++)
+                b->errors++;
+    }
+    return NULL;
+}
+
+// ============================================================================
+//                                  ONE RUN
+// ----------------------------------------------------------------------------
+// Returns millions of items per second.
+// ============================================================================
+static double run(long items, size_t cap, size_t batch) {
+    bench_t *b = aligned_alloc(CACHE_LINE, sizeof(bench_t));
+    b->items  = items;
+    b->batch  = batch;
+    b->errors = 0;
+    b->mbuf   = NULL;
+    if (long_ring_init(&b->ring, cap) == -1) {
+        perror("long_ring_init");
+        exit(1);
+    }
+    if (batch == 0) {
+        b->mbuf = calloc(1, sizeof(mutex_buf_t));
+        pthread_mutex_init(&b->mbuf->lock, NULL);
+    }
+    pthread_barrier_init(&b->start, NULL, 3);
+
+    pthread_t prod, cons;
+    pthread_create(&prod, NULL, batch ? ring_producer : mutex_producer, b);
+    pthread_create(&cons, NULL, batch ? ring_consumer : mutex_consumer, b);
+
+    long long t0 = now_ns();
+    pthread_barrier_wait(&b->start);
+    pthread_join(prod, NULL);
+    pthread_join(cons, NULL);
+    double secs = (now_ns() - t0) / 1e9;
+
+    if (b->errors)
+        fprintf(stderr, "warning: %ld items out of order or corrupted\n", b->errors);
+
+    if (b->mbuf) {
+        pthread_mutex_destroy(&b->mbuf->lock);
+        free(b->mbuf);
+    }
+    long_ring_destroy(&b->ring);
+    pthread_barrier_destroy(&b->start);
+    free(b);
+    return items / secs / 1e6;
+}
+
+// ============================================================================
+//                                     MAIN
+// ============================================================================
+int main(int argc, char *argv[]) {
+    long   items = DEFAULT_ITEMS;
+    size_t cap   = DEFAULT_CAP;
+    int    opt;
+
+    while ((opt = getopt(argc, argv, "n:c:")) != -1) {
+        switch (opt) {
+        case 'n': items = atol(optarg);          break;
+        case 'c': cap   = (size_t)atol(optarg);  break;
+        default:
+            fprintf(stderr, "usage: %s [-n items] [-c capacity]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (items < 1 || cap < 2) {
+        fprintf(stderr, "bad -n / -c\n");
+        return 1;
+    }
+
+    printf("%ld items, ring capacity %zu (Mitems/s)\n\n", items, cap);
+
+    // the baseline is far slower; give it a tenth of the items
+    long few = items / 10 > 0 ? items / 10 : 1;
+    printf("%-16s %10.2f\n", "malloc+mutex", run(few, cap, 0));
+    printf("%-16s %10.2f\n", "spsc", run(items, cap, 1));
+
+    static const size_t batches[] = { 16, 64, MAX_BATCH };
+    for (size_t i = 0; i < sizeof(batches) / sizeof(batches[0]); i++) {
+        char label[32];
+        snprintf(label, sizeof(label), "spsc batch %zu", batches[i]);
+        printf("%-16s %10.2f\n", label, run(items, cap, batches[i]));
+        fflush(stdout);
+    }
+    return 0;
+}
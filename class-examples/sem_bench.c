@@ -0,0 +1,65 @@
+// sem_bench.c
+//
+// Futex semaphore (../common/sem.h) vs glibc sem_t.
+// -------------------------------------------------------
+// Build:
+//   gcc -O2 -pthread sem_bench.c sem_bench_posix.c -o sem_bench
+//
+// Run:
+//   ./sem_bench [iterations] [max_threads]
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../common/sem.h"
+
+// ============================================================================
+//                          CUSTOM SEMAPHORE SIDE
+// ============================================================================
+#define BENCH_SEM_T       semaphore
+#define BENCH_INIT(s, v)  sem_init_value((s), (v))
+#define BENCH_WAIT(s)     sem_wait(s)
+#define BENCH_POST(s)     sem_post(s)
+#define BENCH_DESTROY(s)  ((void)(s))
+#define BENCH_NAME(x)     custom_sem_##x
+
+#include "sem_bench_body.h"
+
+// glibc side, compiled separately in sem_bench_posix.c
+double posix_sem_uncontended(long iters);
+double posix_sem_contended(int threads, long iters);
+double posix_sem_pingpong(long iters);
+
+// ============================================================================
+//                                     MAIN
+// ============================================================================
+int main(int argc, char *argv[]) {
+    long iters       = argc > 1 ? atol(argv[1]) : 1000000;
+    int  max_threads = argc > 2 ? atoi(argv[2]) : cpu_count();
+    if (iters < 1 || max_threads < 1) {
+        fprintf(stderr, "usage: %s [iterations] [max_threads]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%ld iterations (Mops/s)\n\n", iters);
+    printf("%-22s %10s %10s\n", "", "futex", "glibc");
+    printf("%-22s %10.2f %10.2f\n", "uncontended",
+           custom_sem_uncontended(iters) / 1e6, posix_sem_uncontended(iters) / 1e6);
+
+    long pp = iters / 10 > 0 ? iters / 10 : 1;   // every op sleeps: keep it short
+    printf("%-22s %10.3f %10.3f\n", "ping-pong",
+           custom_sem_pingpong(pp) / 1e6, posix_sem_pingpong(pp) / 1e6);
+
+    for (int t = 2; ; t = (t * 2 > max_threads && t < max_threads) ? max_threads : t * 2) {
+        char label[32];
+        snprintf(label, sizeof(label), "contended, %d threads", t);
+        printf("%-22s %10.2f %10.2f\n", label,
+               custom_sem_contended(t, iters / t) / 1e6,
+               posix_sem_contended(t, iters / t) / 1e6);
+        if (t >= max_threads)
+            break;
+    }
+    return 0;
+}
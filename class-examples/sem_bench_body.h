@@ -0,0 +1,101 @@
+// sem_bench_body.h
+//
+// Semaphore benchmark body, instantiated once per semaphore type.
+// -------------------------------------------------------
+// Our semaphore and glibc's sem_t share function names, so they can't live in
+// the same file. Each side defines these and then includes this file:
+//
+//   BENCH_SEM_T              the semaphore type
+//   BENCH_INIT(s, v)         initialise *s to v
+//   BENCH_WAIT(s), BENCH_POST(s)
+//   BENCH_DESTROY(s)
+//   BENCH_NAME(x)            prefixes the exported function names
+//
+// Exports (all return operations per second):
+//   BENCH_NAME(uncontended)(iters)        one thread, wait+post pairs
+//   BENCH_NAME(contended)(threads, iters) threads share a count-1 semaphore
+//   BENCH_NAME(pingpong)(iters)           two threads hand a token back and
+//                                         forth; every wait sleeps, every
+//                                         post wakes
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "../common/bench.h"
+
+typedef struct {
+    BENCH_SEM_T *a, *b;
+    long         iters;
+} BENCH_NAME(arg_t);
+
+double BENCH_NAME(uncontended)(long iters) {
+    BENCH_SEM_T s;
+    BENCH_INIT(&s, 1);
+
+    long long t0 = now_ns();
+    for (long i = 0; i < iters; i++) {
+        BENCH_WAIT(&s);
+        BENCH_POST(&s);
+    }
+    long long dt = now_ns() - t0;
+
+    BENCH_DESTROY(&s);
+    return dt > 0 ? iters * 1e9 / dt : 0.0;
+}
+
+static void *BENCH_NAME(contend_worker)(void *p) {
+    BENCH_NAME(arg_t) *arg = p;
+    for (long i = 0; i < arg->iters; i++) {
+        BENCH_WAIT(arg->a);
+        BENCH_POST(arg->a);
+    }
+    return NULL;
+}
+
+double BENCH_NAME(contended)(int threads, long iters) {
+    BENCH_SEM_T s;
+    BENCH_INIT(&s, 1);
+    BENCH_NAME(arg_t) arg = { &s, NULL, iters };
+
+    pthread_t *tids = malloc(sizeof(pthread_t) * threads);
+    long long  t0   = now_ns();
+    for (int i = 0; i < threads; i++)
+        pthread_create(&tids[i], NULL, BENCH_NAME(contend_worker), &arg);
+    for (int i = 0; i < threads; i++)
+        pthread_join(tids[i], NULL);
+    long long dt = now_ns() - t0;
+
+    free(tids);
+    BENCH_DESTROY(&s);
+    return dt > 0 ? (double)threads * iters * 1e9 / dt : 0.0;
+}
+
+static void *BENCH_NAME(pong)(void *p) {
+    BENCH_NAME(arg_t) *arg = p;
+    for (long i = 0; i < arg->iters; i++) {
+        BENCH_WAIT(arg->b);
+        BENCH_POST(arg->a);
+    }
+    return NULL;
+}
+
+double BENCH_NAME(pingpong)(long iters) {
+    BENCH_SEM_T a, b;
+    BENCH_INIT(&a, 0);
+    BENCH_INIT(&b, 0);
+    BENCH_NAME(arg_t) arg = { &a, &b, iters };
+
+    pthread_t tid;
+    long long t0 = now_ns();
+    pthread_create(&tid, NULL, BENCH_NAME(pong), &arg);
+    for (long i = 0; i < iters; i++) {
+        BENCH_POST(&b);
+        BENCH_WAIT(&a);
+    }
+    pthread_join(tid, NULL);
+    long long dt = now_ns() - t0;
+
+    BENCH_DESTROY(&a);
+    BENCH_DESTROY(&b);
+    return dt > 0 ? 2.0 * iters * 1e9 / dt : 0.0;
+}
@@ -0,0 +1,16 @@
+// sem_bench_posix.c
+//
+// glibc sem_t side of the semaphore benchmark (see sem_bench.c).
+
+#define _GNU_SOURCE
+
+#include <semaphore.h>
+
+#define BENCH_SEM_T       sem_t
+#define BENCH_INIT(s, v)  sem_init((s), 0, (v))
+#define BENCH_WAIT(s)     sem_wait(s)
+#define BENCH_POST(s)     sem_post(s)
+#define BENCH_DESTROY(s)  sem_destroy(s)
+#define BENCH_NAME(x)     posix_sem_##x
+
+#include "sem_bench_body.h"
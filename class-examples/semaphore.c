@@ -1,21 +1,28 @@
 // semaphore.c
-
-//#include <semaphore.h>
+//
+// Build:
+//   gcc -pthread semaphore.c -o semaphore
+//
+// Run:
+//   ./semaphore [trace.json]
+//   With a file name the threads record sem_wait / holding spans
+//   (../common/trace.h) instead of printing, and the spans are written to
+//   the file as Chrome-trace JSON at exit.
+//
+// Benchmark against glibc sem_t:
+//   gcc -O2 -pthread sem_bench.c sem_bench_posix.c -o sem_bench
+
+#define _GNU_SOURCE // syscall() for the futex wrappers
+
+//#include <semaphore.h>  // ours uses the same names, see ../common/sem.h
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <signal.h>
-#include <mqueue.h>
-#include <fcntl.h>
-#include <stdbool.h>
 #include <stdatomic.h>
-#include <stddef.h> // NULL macro
-#include <string.h>
-#include <sys/stat.h>
-#include <sys/types.h>
-#include <time.h>
 #include <unistd.h>
-#include <errno.h>
+
+#include "../common/sem.h"
+#include "../common/trace.h"
 
 //==============================================================================
 // SEMAPHORES
@@ -32,36 +39,35 @@
 
 //==============================================================================
 //              CUSTOM SEMAPHORE IMPLEMENTATION
+//------------------------------------------------------------------------------
+// Lives in ../common/sem.h so other programs can share it.
+//
+// Waiters queue in a FIFO of nodes on their own stacks, each node with its
+// own futex word. sem_post() hands the resource directly to the oldest waiter
+// and wakes only that one, so a thread that posts and comes straight back
+// cannot barge ahead of the sleepers. sem_post_n(s, n) does the same for the
+// n oldest in one call. The count and the waitlist change together under one
+// lock, so no two threads can see them out of step.
+//
+// sem_trywait() and sem_timedwait() behave like their POSIX counterparts.
+// There is no system call unless a wait really sleeps or a post really has a
+// sleeper.
 //==============================================================================
-typedef struct {
-    atomic_int  value;     // Resources
-    pid_t       list[100]; // Waiting processes
-    atomic_int  count;     // Length of waitlist
-
-} semaphore;
 
 //===================== FUNCTION PROTOTYPES ====================================
 void* thread_1(void* arg);
 void* thread_2(void* arg);
 void* thread_3(void* arg);
-void  block();
-void  wake_up();
-int   sem_wait(semaphore* s);
-int   sem_post(semaphore* s);
 
 //======================== CONFIGURATION =======================================
 
-#define QUEUE_NAME "/my_queue"
 #define RESOURCES     2
-#define WAITLIST_SIZE 100
 #define THREAD_COUNT  3
+#define TRACE_EVENTS  64
 
-struct mq_attr attr = {
-    .mq_flags   = 0,    // Blocking queue
-    .mq_maxmsg  = 1,    // Maximum number of messages in the queue
-    .mq_msgsize = 1,    // Maximum message size in bytes
-    .mq_curmsgs = 0     // Current number of messages (automatically set by OS, often ignored here)
-};
+// printf, unless the events are being traced instead
+static int tracing;
+#define LOG(...) do { if (!tracing) printf(__VA_ARGS__); } while (0)
 
 //==============================================================================
 //                                      MAIN
@@ -69,16 +75,20 @@ struct mq_attr attr = {
 int main(int argc, char *argv[]) {
     
     printf("Hello world!\n");
-   
-    mq_unlink(QUEUE_NAME);
+
+    if (argc > 1) {
+        if (trace_init(argv[1], TRACE_EVENTS) == -1) {
+            perror("trace_init");
+            return 1;
+        }
+        tracing = 1;
+    }
 
     // Create Semaphore
     semaphore* my_s = malloc(sizeof(semaphore));
     
     // Initialize Semaphore
-    my_s->value = RESOURCES;
-    memset(my_s->list, 0, sizeof(my_s->list));
-    my_s->count = 0;
+    sem_init_value(my_s, RESOURCES);
     
     // Create Threads
     pthread_t threads[THREAD_COUNT];
@@ -108,16 +118,21 @@ int main(int argc, char *argv[]) {
 void* thread_1(void* arg) {
     semaphore* my_s = arg; // create alias
 
-    printf("[THREAD 1] Created\n");
+    trace_thread("thread 1");
+    LOG("[THREAD 1] Created\n");
+    trace_begin("sem_wait");
     sem_wait(my_s);
+    trace_end("sem_wait");
     
-    printf("[THREAD 1] Holding for 10 Seconds...\n");
+    LOG("[THREAD 1] Holding for 10 Seconds...\n");
+    trace_begin("holding");
     sleep(10);
+    trace_end("holding");
     
-    printf("[THREAD 1] Releasing resource\n");
+    LOG("[THREAD 1] Releasing resource\n");
     sem_post(my_s);
 
-    printf("[THREAD 1] Exiting\n");
+    LOG("[THREAD 1] Exiting\n");
     pthread_exit(NULL);
 }
 
@@ -128,16 +143,21 @@ void* thread_1(void* arg) {
 void* thread_2(void* arg) {
     semaphore* my_s = arg; // create alias
 
-    printf("[THREAD 2] Created\n");
+    trace_thread("thread 2");
+    LOG("[THREAD 2] Created\n");
+    trace_begin("sem_wait");
     sem_wait(my_s);
+    trace_end("sem_wait");
     
-    printf("[THREAD 2] Holding for 10 Seconds...\n");
+    LOG("[THREAD 2] Holding for 10 Seconds...\n");
+    trace_begin("holding");
     sleep(10);
+    trace_end("holding");
     
-    printf("[THREAD 2] Releasing resource\n");
+    LOG("[THREAD 2] Releasing resource\n");
     sem_post(my_s);
 
-    printf("[THREAD 2] Exiting\n");
+    LOG("[THREAD 2] Exiting\n");
     pthread_exit(NULL);
 }
 
@@ -148,119 +168,20 @@ void* thread_2(void* arg) {
 void* thread_3(void* arg) {
     semaphore* my_s = arg; // create alias
 
-    printf("[THREAD 3] Created\n");
+    trace_thread("thread 3");
+    LOG("[THREAD 3] Created\n");
+    trace_begin("sem_wait");
     sem_wait(my_s);
+    trace_end("sem_wait");
     
-    printf("[THREAD 3] Holding for 10 Seconds...\n");
+    LOG("[THREAD 3] Holding for 10 Seconds...\n");
+    trace_begin("holding");
     sleep(10);
+    trace_end("holding");
     
-    printf("[THREAD 3] Releasing resource\n");
+    LOG("[THREAD 3] Releasing resource\n");
     sem_post(my_s);
 
-    printf("[THREAD 3] Exiting\n");
+    LOG("[THREAD 3] Exiting\n");
     pthread_exit(NULL);
 }
-
-//=============================================================================
-//                                  BLOCK
-//=============================================================================
-void block() {
-    
-    bool   buffer;
-    ssize_t bytes_read;
-    mqd_t   mq;
-
-    // Message Queue Open
-    mq = mq_open(QUEUE_NAME, O_CREAT | O_RDONLY, 0666, &attr); 
-    if (mq == (mqd_t)-1) {
-        perror("mq_open for receiving");
-        exit(EXIT_FAILURE);
-    }
-
-    // Message Queue Receive                        <- Blocks until receive
-    bytes_read = mq_receive(mq, (const char*)&buffer, 1, NULL);
-    if (bytes_read == -1) {
-        perror("mq_receive");
-        exit(EXIT_FAILURE);
-    }
-    printf("\tMessage received: %d\n", buffer);
-    mq_close(mq);
-}
-
-//==============================================================================
-//                                      SEM_WAIT
-//------------------------------------------------------------------------------
-// Decrement Semaphore, possibly blocks.
-//  Parameters: 1. sem_t* s;
-//      
-//      Calling process holds 1 resource, or blocks if none are avaliable.
-//==============================================================================
-int sem_wait(semaphore* s) {
-   
-
-    printf("\t%d resources are avaliable.\n", s->value);
-
-    s->value--; // Remove 1 resource <- held in current process
-    
-    // If No Resources Are Available
-    if (s->value < 0) {
-        
-        // Add Process to waitlist
-        s->list[s->count];
-        s->count++;
-        printf("\tAdded to waitlist\n");
-        
-        // Block until a resource becomes available
-        printf("\tBlocked\n");
-        block();
-        printf("\tWoken up\n");
-
-        // Pop from the waitlist
-        s->list[s->count] = NULL;
-        s->count--;
-    } else {
-        printf("\tServed immediately\n");
-    }
-    printf("\tHolding 1 resource\n");
-    return 0;
-}
-
-
-//=============================================================================
-//                                 WAKE_UP 
-//=============================================================================
-void wake_up() {
-
-    mqd_t   mq;
-
-    // Message Queue Open / Create
-    mq = mq_open(QUEUE_NAME, O_CREAT | O_WRONLY, 0666, &attr);
-    if (mq == (mqd_t)-1) {
-        perror("mq_open");
-        exit(EXIT_FAILURE);
-    }
-
-    // Send Message to Message Queue
-    bool message = true;
-    if (mq_send(mq, (const char*)&message, 1, 0) == -1) { // (mq, msg, siz, prio)
-        perror("mq_send");
-        exit(EXIT_FAILURE);
-    }
-    printf("\tMessage sent: %d\n", message);
-    mq_close(mq);
-}   
-
-//==============================================================================
-//                                      SEM_POST
-//------------------------------------------------------------------------------
-// Increment Semaphore (Release Resource).
-//==============================================================================
-int sem_post(semaphore* s) {
-    
-    s->value++;
-
-    // If Waitinglist is full
-    if (s->count > 0) {
-        wake_up();
-    }
-}
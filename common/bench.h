@@ -0,0 +1,48 @@
+// bench.h
+//
+// Small helpers shared by the benchmark programs.
+// -------------------------------------------------------
+// Header only; include it from any assignment directory:
+//   #include "../common/bench.h"
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <time.h>
+#include <unistd.h>
+
+// ============================================================================
+//                                CONFIGURATION
+// ============================================================================
+#define CACHE_LINE 64   // x86-64 / most ARM64; keeps hot fields apart
+
+// Pads a field out to its own cache line (no false sharing).
+#define CACHE_ALIGNED __attribute__((aligned(CACHE_LINE)))
+
+// ============================================================================
+//                                  HELPERS
+// ============================================================================
+
+// Monotonic clock in nanoseconds.
+static inline long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Online CPUs (at least 1).
+static inline int cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+// Tells the CPU we are spinning (cheaper for the sibling hyperthread).
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+#endif // BENCH_H
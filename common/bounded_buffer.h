@@ -0,0 +1,219 @@
+// bounded_buffer.h
+//
+// Blocking bounded buffer (the OSTEP producer/consumer) with batch
+// operations and spin-then-park waiting.
+// -------------------------------------------------------
+// Header only, instantiated once per item type (like spsc_ring.h):
+//
+//   #define BB_T        long
+//   #define BB_NAME(x)  long_bb_##x
+//   #include "../common/bounded_buffer.h"
+//
+// gives long_bb_t and long_bb_init / _destroy / _put / _get / _put_many /
+// _get_many. BB_T and BB_NAME are #undef'd at the end.
+//
+// Any number of producers and consumers. One mutex guards the slots, with
+// not_full / not_empty condition variables, as in the book. On top of that:
+//
+//   batches    put_many / get_many move as many items as fit under one lock
+//              acquisition and one wakeup, instead of one of each per item
+//
+//   spinning   before parking on a condvar, a waiter watches `count`
+//              (readable without the lock) for up to `budget` rounds; if the
+//              other side catches up in time it never sleeps, and nobody has
+//              to wake it. The budget adapts per side: it doubles when a spin
+//              pays off and halves when the waiter had to park anyway, within
+//              [BB_SPIN_MIN, BB_SPIN_MAX]. With one CPU spinning can only
+//              delay the thread we are waiting for, so it is switched off.
+//
+//   wakeups    only when someone is parked on that condvar
+//
+// Counters (relaxed, for reporting): how many waits were satisfied by
+// spinning and how many parked, per side.
+
+#ifndef BB_T
+#error "define BB_T and BB_NAME(x) before including bounded_buffer.h"
+#endif
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+// ============================================================================
+//                                CONFIGURATION
+// ============================================================================
+#define BB_SPIN_MIN    16     // spin budget bounds (rounds)
+#define BB_SPIN_MAX    4096
+#define BB_SPIN_START  256
+
+// ============================================================================
+//                                    TYPE
+// ============================================================================
+typedef BB_T BB_NAME(item_t);   // so `const` applies to the item, pointer or not
+
+typedef struct {
+    atomic_long spins;    // waits that ended while spinning
+    atomic_long parks;    // waits that slept on the condvar
+    atomic_int  budget;   // current spin rounds before parking
+    int         sleepers; // parked on this side's condvar (lock held)
+} CACHE_ALIGNED BB_NAME(side_t);
+
+typedef struct {
+    pthread_mutex_t  lock;
+    pthread_cond_t   not_full, not_empty;
+    BB_T            *items;
+    size_t           cap;
+    size_t           head, tail;    // next get / next put (free-running)
+    atomic_size_t    count;         // items in buffer; written under lock
+    int              spin_ok;       // 0 on a single CPU
+    BB_NAME(side_t)  put_side, get_side;
+} BB_NAME(t);
+
+// Returns 0, or -1 if the slots cannot be allocated.
+static inline int BB_NAME(init)(BB_NAME(t) *b, size_t capacity) {
+    b->items = capacity ? malloc(sizeof(BB_T) * capacity) : NULL;
+    if (!b->items)
+        return -1;
+    pthread_mutex_init(&b->lock, NULL);
+    pthread_cond_init(&b->not_full, NULL);
+    pthread_cond_init(&b->not_empty, NULL);
+    b->cap  = capacity;
+    b->head = b->tail = 0;
+    atomic_init(&b->count, 0);
+    b->spin_ok = cpu_count() > 1;
+
+    BB_NAME(side_t) *sides[2] = { &b->put_side, &b->get_side };
+    for (int i = 0; i < 2; i++) {
+        atomic_init(&sides[i]->spins, 0);
+        atomic_init(&sides[i]->parks, 0);
+        atomic_init(&sides[i]->budget, BB_SPIN_START);
+        sides[i]->sleepers = 0;
+    }
+    return 0;
+}
+
+static inline void BB_NAME(destroy)(BB_NAME(t) *b) {
+    pthread_cond_destroy(&b->not_empty);
+    pthread_cond_destroy(&b->not_full);
+    pthread_mutex_destroy(&b->lock);
+    free(b->items);
+}
+
+// ============================================================================
+//                                   WAITING
+// ----------------------------------------------------------------------------
+// Called with the lock held when this side can't proceed: `want_room` is
+// true for producers (wait for count < cap), false for consumers (count > 0).
+// Returns with the lock held and the condition true.
+// ============================================================================
+static inline int BB_NAME(ready)(BB_NAME(t) *b, int want_room) {
+    size_t c = atomic_load_explicit(&b->count, memory_order_relaxed);
+    return want_room ? c < b->cap : c > 0;
+}
+
+static inline void BB_NAME(wait)(BB_NAME(t) *b, int want_room) {
+    BB_NAME(side_t) *s    = want_room ? &b->put_side : &b->get_side;
+    pthread_cond_t  *cond = want_room ? &b->not_full : &b->not_empty;
+
+    if (b->spin_ok) {
+        int budget = atomic_load_explicit(&s->budget, memory_order_relaxed);
+        pthread_mutex_unlock(&b->lock);
+        int ok = 0;
+        for (int i = 0; i < budget && !ok; i++) {
+            cpu_relax();
+            ok = BB_NAME(ready)(b, want_room);
+        }
+        pthread_mutex_lock(&b->lock);
+
+        if (ok && BB_NAME(ready)(b, want_room)) {
+            atomic_fetch_add_explicit(&s->spins, 1, memory_order_relaxed);
+            if (budget < BB_SPIN_MAX)
+                atomic_store_explicit(&s->budget, budget * 2, memory_order_relaxed);
+            return;
+        }
+        if (budget > BB_SPIN_MIN)
+            atomic_store_explicit(&s->budget, budget / 2, memory_order_relaxed);
+    }
+
+    atomic_fetch_add_explicit(&s->parks, 1, memory_order_relaxed);
+    s->sleepers++;
+    while (!BB_NAME(ready)(b, want_room))
+        pthread_cond_wait(cond, &b->lock);
+    s->sleepers--;
+}
+
+// Lock held: `n` items/slots just became available to the other side.
+static inline void BB_NAME(wake)(BB_NAME(t) *b, int to_consumers, size_t n) {
+    BB_NAME(side_t) *s    = to_consumers ? &b->get_side : &b->put_side;
+    pthread_cond_t  *cond = to_consumers ? &b->not_empty : &b->not_full;
+
+    if (s->sleepers == 0)
+        return;
+    if (n == 1)
+        pthread_cond_signal(cond);
+    else
+        pthread_cond_broadcast(cond);
+}
+
+// ============================================================================
+//                                  PRODUCER
+// ============================================================================
+
+// Puts all n items, blocking while the buffer is full. Items go in as room
+// appears, so a large batch can interleave with other producers.
+static inline void BB_NAME(put_many)(BB_NAME(t) *b, const BB_NAME(item_t) *items, size_t n) {
+    pthread_mutex_lock(&b->lock);
+    while (n > 0) {
+        if (!BB_NAME(ready)(b, 1))
+            BB_NAME(wait)(b, 1);
+
+        size_t room = b->cap - atomic_load_explicit(&b->count, memory_order_relaxed);
+        size_t k    = n < room ? n : room;
+        for (size_t i = 0; i < k; i++)
+            b->items[b->tail++ % b->cap] = items[i];
+        atomic_fetch_add_explicit(&b->count, k, memory_order_relaxed);
+        items += k;
+        n     -= k;
+
+        BB_NAME(wake)(b, 1, k);
+    }
+    pthread_mutex_unlock(&b->lock);
+}
+
+static inline void BB_NAME(put)(BB_NAME(t) *b, BB_T item) {
+    BB_NAME(put_many)(b, &item, 1);
+}
+
+// ============================================================================
+//                                  CONSUMER
+// ============================================================================
+
+// Blocks until at least one item is there, then takes up to max.
+// Returns how many (>= 1).
+static inline size_t BB_NAME(get_many)(BB_NAME(t) *b, BB_T *out, size_t max) {
+    pthread_mutex_lock(&b->lock);
+    if (!BB_NAME(ready)(b, 0))
+        BB_NAME(wait)(b, 0);
+
+    size_t have = atomic_load_explicit(&b->count, memory_order_relaxed);
+    size_t k    = max < have ? max : have;
+    for (size_t i = 0; i < k; i++)
+        out[i] = b->items[b->head++ % b->cap];
+    atomic_fetch_sub_explicit(&b->count, k, memory_order_relaxed);
+
+    BB_NAME(wake)(b, 0, k);
+    pthread_mutex_unlock(&b->lock);
+    return k;
+}
+
+static inline BB_T BB_NAME(get)(BB_NAME(t) *b) {
+    BB_T item;
+    BB_NAME(get_many)(b, &item, 1);
+    return item;
+}
+
+#undef BB_T
+#undef BB_NAME
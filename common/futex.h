@@ -0,0 +1,68 @@
+// futex.h
+//
+// Thin wrappers around the Linux futex(2) syscall.
+// -------------------------------------------------------
+// Header only; include it from any assignment directory:
+//   #include "../common/futex.h"
+//
+// A futex is just a 32-bit int in memory plus a kernel wait queue keyed by
+// its address. futex_wait() sleeps only if *addr still equals `expected`
+// (checked atomically by the kernel), so a wake that lands between our
+// check and the sleep is never lost.
+//
+// syscall() needs _GNU_SOURCE (or _DEFAULT_SOURCE) defined before the first
+// #include of the including file.
+//
+// The *_private variants are for threads of one process (faster: no
+// shared-mapping lookup). The plain ones also work on memory shared between
+// processes (shm_open / MAP_SHARED).
+
+#ifndef FUTEX_H
+#define FUTEX_H
+
+#include <errno.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <stdatomic.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// ============================================================================
+//                                  WRAPPERS
+// ----------------------------------------------------------------------------
+// futex_wait*() return 0 when woken (or spuriously), -1 with errno set
+// otherwise (EAGAIN: value already changed, ETIMEDOUT, EINTR).
+// futex_wake*() return the number of waiters woken.
+// ============================================================================
+static inline long futex_call(atomic_int *addr, int op, int val,
+                              const struct timespec *timeout) {
+    return syscall(SYS_futex, (int *)addr, op, val, timeout, NULL, 0);
+}
+
+static inline int futex_wait(atomic_int *addr, int expected) {
+    return (int)futex_call(addr, FUTEX_WAIT, expected, NULL);
+}
+
+static inline int futex_wait_private(atomic_int *addr, int expected) {
+    return (int)futex_call(addr, FUTEX_WAIT_PRIVATE, expected, NULL);
+}
+
+// Relative timeout; NULL waits forever.
+static inline int futex_timedwait(atomic_int *addr, int expected,
+                                  const struct timespec *rel, int shared) {
+    return (int)futex_call(addr, shared ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE,
+                           expected, rel);
+}
+
+static inline int futex_wake(atomic_int *addr, int n) {
+    return (int)futex_call(addr, FUTEX_WAKE, n, NULL);
+}
+
+static inline int futex_wake_private(atomic_int *addr, int n) {
+    return (int)futex_call(addr, FUTEX_WAKE_PRIVATE, n, NULL);
+}
+
+#define FUTEX_WAKE_ALL INT_MAX
+
+#endif // FUTEX_H
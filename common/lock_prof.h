@@ -0,0 +1,343 @@
+// lock_prof.h
+//
+// Lock-contention profiler for pthread mutexes and condition variables.
+// -------------------------------------------------------
+// Opt-in, no source changes: force-include it when building,
+//   cd as3-sync/deliverables
+//   gcc -pthread -include ../../common/lock_prof.h p1_b.c -o p1_b
+// and a report goes to stderr when the program exits. (Or #include it after
+// <pthread.h> in a file of your own.) It #defines pthread_mutex_lock /
+// _trylock / _unlock and pthread_cond_wait / _timedwait to wrappers that
+// record the caller's __FILE__:__LINE__, so every row of the report is one
+// lock at one call site:
+//     acq          acquisitions (for cond waits: wakeups)
+//     contended    lock: the mutex was already held; trylock: EBUSY
+//     wait         time blocked: lock = getting a held mutex,
+//                  cond_wait = asleep on the condition plus re-locking
+//     hold         lock to unlock, attributed to the site that locked
+// sorted by total wait.
+//
+// Cost: every lock is tried with pthread_mutex_trylock first, so an
+// uncontended lock adds a thread-local table lookup and no clock read.
+// Contended locks and cond waits are already slow and are always timed.
+// Hold times need two clock reads, so only one acquisition in
+// LOCK_PROF_SAMPLE (environment, default 64) is timed; the report shows
+// the sampled average and max.
+//
+// Each thread keeps its own table (no locks, no shared counters); tables
+// are merged at exit and never freed, so a thread still running then can go
+// on recording safely, though its rows may be read mid-update.
+
+#ifndef LOCK_PROF_H
+#define LOCK_PROF_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE             // when force-included ahead of a file that needs it
+#endif
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+
+// ============================================================================
+//                                CONFIGURATION
+// ============================================================================
+#define LP_SITES     256    // (lock, call site) pairs per thread, power of two
+#define LP_MAX_HELD  16     // sampled holds tracked per thread
+#define LP_SAMPLE    64     // default LOCK_PROF_SAMPLE
+#define LP_TOP       25     // rows in the report
+
+enum { LP_LOCK, LP_TRYLOCK, LP_COND_WAIT };
+static const char *const lp_op_name[] = { "lock", "trylock", "cond_wait" };
+
+// ============================================================================
+//                                    TYPES
+// ============================================================================
+typedef struct {
+    const void *lock;              // NULL = free slot
+    const char *file;
+    int         line;
+    int         op;
+    long        acq, contended;
+    long        holds;             // sampled holds
+    long long   wait_total, wait_max;
+    long long   hold_total, hold_max;
+} lp_site_t;
+
+typedef struct lp_thread {
+    lp_site_t         sites[LP_SITES];
+    long              dropped;                 // table full
+    unsigned          tick;                    // sampling counter
+    int               nheld;
+    struct {
+        const void *lock;
+        lp_site_t  *site;
+        long long   since;
+    } held[LP_MAX_HELD];
+    struct lp_thread *next;
+} lp_thread_t;
+
+static struct {
+    pthread_once_t          once;
+    unsigned                sample;
+    _Atomic(lp_thread_t *)  threads;
+} lp_state = { PTHREAD_ONCE_INIT, LP_SAMPLE, NULL };
+
+static _Thread_local lp_thread_t *lp_self;
+
+static void lp_report(void);
+
+// ============================================================================
+//                                  PER THREAD
+// ============================================================================
+static void lp_init_once(void) {
+    const char *env = getenv("LOCK_PROF_SAMPLE");
+    if (env && atoi(env) > 0)
+        lp_state.sample = (unsigned)atoi(env);
+    atexit(lp_report);
+}
+
+// NULL if the table can't be allocated (the thread then goes unprofiled)
+static inline lp_thread_t *lp_thread(void) {
+    if (lp_self)
+        return lp_self;
+
+    pthread_once(&lp_state.once, lp_init_once);
+    lp_thread_t *t = calloc(1, sizeof(lp_thread_t));
+    if (!t)
+        return NULL;
+    t->next = atomic_load_explicit(&lp_state.threads, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&lp_state.threads, &t->next, t,
+                                                  memory_order_release,
+                                                  memory_order_relaxed))
+        ;
+    return lp_self = t;
+}
+
+// Finds or adds the row for (lock, file:line, op); NULL if the table is full.
+static inline lp_site_t *lp_site(lp_thread_t *t, const void *lock,
+                                 const char *file, int line, int op) {
+    uintptr_t h = ((uintptr_t)lock >> 4) ^ ((uintptr_t)file >> 3) ^
+                  (uintptr_t)line * 2654435761u ^ (uintptr_t)op;
+    for (int probe = 0; probe < LP_SITES; probe++) {
+        lp_site_t *s = &t->sites[(h + probe) & (LP_SITES - 1)];
+        if (s->lock == lock && s->file == file && s->line == line && s->op == op)
+            return s;
+        if (!s->lock) {
+            s->lock = lock;
+            s->file = file;
+            s->line = line;
+            s->op   = op;
+            return s;
+        }
+    }
+    t->dropped++;
+    return NULL;
+}
+
+static inline void lp_waited(lp_site_t *s, long long ns) {
+    s->wait_total += ns;
+    if (ns > s->wait_max)
+        s->wait_max = ns;
+}
+
+// Starts a hold sample for one acquisition in `sample`
+static inline void lp_acquired(lp_thread_t *t, lp_site_t *s, const void *lock) {
+    if (++t->tick % lp_state.sample != 0 || t->nheld == LP_MAX_HELD)
+        return;
+    t->held[t->nheld].lock  = lock;
+    t->held[t->nheld].site  = s;
+    t->held[t->nheld].since = now_ns();
+    t->nheld++;
+}
+
+// Ends the hold sample for lock, if there is one
+static inline void lp_released(lp_thread_t *t, const void *lock) {
+    for (int k = t->nheld - 1; k >= 0; k--) {
+        if (t->held[k].lock != lock)
+            continue;
+        long long ns = now_ns() - t->held[k].since;
+        lp_site_t *s = t->held[k].site;
+        s->holds++;
+        s->hold_total += ns;
+        if (ns > s->hold_max)
+            s->hold_max = ns;
+        t->held[k] = t->held[--t->nheld];
+        return;
+    }
+}
+
+// ============================================================================
+//                                  WRAPPERS
+// ============================================================================
+static inline int lock_prof_mutex_lock(pthread_mutex_t *m, const char *file, int line) {
+    lp_thread_t *t = lp_thread();
+    lp_site_t   *s = t ? lp_site(t, m, file, line, LP_LOCK) : NULL;
+    if (!s)
+        return pthread_mutex_lock(m);
+
+    int rc = pthread_mutex_trylock(m);
+    if (rc == EBUSY) {
+        long long t0 = now_ns();
+        rc = pthread_mutex_lock(m);
+        lp_waited(s, now_ns() - t0);
+        s->contended++;
+    }
+    if (rc == 0) {
+        s->acq++;
+        lp_acquired(t, s, m);
+    }
+    return rc;
+}
+
+static inline int lock_prof_mutex_trylock(pthread_mutex_t *m, const char *file, int line) {
+    lp_thread_t *t = lp_thread();
+    lp_site_t   *s = t ? lp_site(t, m, file, line, LP_TRYLOCK) : NULL;
+
+    int rc = pthread_mutex_trylock(m);
+    if (s && rc == 0) {
+        s->acq++;
+        lp_acquired(t, s, m);
+    } else if (s && rc == EBUSY) {
+        s->contended++;
+    }
+    return rc;
+}
+
+static inline int lock_prof_mutex_unlock(pthread_mutex_t *m) {
+    if (lp_self && lp_self->nheld)
+        lp_released(lp_self, m);
+    return pthread_mutex_unlock(m);
+}
+
+static inline int lock_prof_cond_timedwait(pthread_cond_t *c, pthread_mutex_t *m,
+                                           const struct timespec *abs,
+                                           const char *file, int line) {
+    lp_thread_t *t = lp_thread();
+    lp_site_t   *s = t ? lp_site(t, m, file, line, LP_COND_WAIT) : NULL;
+    if (!s)
+        return abs ? pthread_cond_timedwait(c, m, abs) : pthread_cond_wait(c, m);
+
+    if (t->nheld)
+        lp_released(t, m);                     // the wait lets go of m
+    long long t0 = now_ns();
+    int rc = abs ? pthread_cond_timedwait(c, m, abs) : pthread_cond_wait(c, m);
+    lp_waited(s, now_ns() - t0);
+    s->acq++;
+    lp_acquired(t, s, m);                      // and hands it back
+    return rc;
+}
+
+static inline int lock_prof_cond_wait(pthread_cond_t *c, pthread_mutex_t *m,
+                                      const char *file, int line) {
+    return lock_prof_cond_timedwait(c, m, NULL, file, line);
+}
+
+// ============================================================================
+//                                   REPORT
+// ============================================================================
+static int lp_by_key(const void *a, const void *b) {
+    const lp_site_t *x = a, *y = b;
+    if (x->lock != y->lock) return (uintptr_t)x->lock < (uintptr_t)y->lock ? -1 : 1;
+    if (x->file != y->file) return (uintptr_t)x->file < (uintptr_t)y->file ? -1 : 1;
+    if (x->line != y->line) return x->line < y->line ? -1 : 1;
+    return x->op - y->op;
+}
+
+static int lp_by_wait(const void *a, const void *b) {
+    const lp_site_t *x = a, *y = b;
+    if (x->wait_total != y->wait_total)
+        return x->wait_total > y->wait_total ? -1 : 1;
+    return x->acq > y->acq ? -1 : x->acq < y->acq;
+}
+
+static void lp_report(void) {
+    size_t n = 0, cap = 0;
+    long   dropped = 0;
+    int    nthreads = 0;
+    lp_site_t *all = NULL;
+
+    // every thread's rows into one array
+    lp_thread_t *t = atomic_load_explicit(&lp_state.threads, memory_order_acquire);
+    while (t) {
+        for (int k = 0; k < LP_SITES; k++) {
+            if (!t->sites[k].lock)
+                continue;
+            if (n == cap) {
+                cap = cap ? 2 * cap : 1024;
+                lp_site_t *grown = realloc(all, sizeof(lp_site_t) * cap);
+                if (!grown) {
+                    perror("lock_prof");
+                    free(all);
+                    return;
+                }
+                all = grown;
+            }
+            all[n++] = t->sites[k];
+        }
+        dropped += t->dropped;
+        nthreads++;
+        t = t->next;   // tables stay allocated: other threads may still use theirs
+    }
+
+    // same lock and site from different threads -> one row
+    qsort(all, n, sizeof(lp_site_t), lp_by_key);
+    size_t rows = 0;
+    for (size_t k = 0; k < n; k++) {
+        lp_site_t *r = rows ? &all[rows - 1] : NULL;
+        if (r && lp_by_key(r, &all[k]) == 0) {
+            r->acq        += all[k].acq;
+            r->contended  += all[k].contended;
+            r->holds      += all[k].holds;
+            r->wait_total += all[k].wait_total;
+            r->hold_total += all[k].hold_total;
+            if (all[k].wait_max > r->wait_max) r->wait_max = all[k].wait_max;
+            if (all[k].hold_max > r->hold_max) r->hold_max = all[k].hold_max;
+        } else {
+            all[rows++] = all[k];
+        }
+    }
+    qsort(all, rows, sizeof(lp_site_t), lp_by_wait);
+
+    fprintf(stderr, "\nlock profile: %zu lock/site pairs from %d threads, "
+                    "hold times sampled 1/%u\n", rows, nthreads, lp_state.sample);
+    fprintf(stderr, "%-28s %-9s %14s %12s %10s %7s %12s %11s %11s %11s\n", "site", "op", "lock",
+            "acq", "contended", "cont%", "wait total", "wait max", "hold avg", "hold max");
+    for (size_t k = 0; k < rows && k < LP_TOP; k++) {
+        lp_site_t *r = &all[k];
+        char site[64];
+        const char *base = strrchr(r->file, '/');
+        snprintf(site, sizeof(site), "%s:%d", base ? base + 1 : r->file, r->line);
+        fprintf(stderr, "%-28s %-9s %14p %12ld %10ld %6.2f%% %10.2fms %9.1fus ",
+                site, lp_op_name[r->op], r->lock, r->acq, r->contended,
+                r->acq ? 100.0 * r->contended / r->acq : 0.0,
+                r->wait_total / 1e6, r->wait_max / 1e3);
+        if (r->holds)
+            fprintf(stderr, "%9.2fus %9.1fus\n", r->hold_total / 1e3 / r->holds, r->hold_max / 1e3);
+        else
+            fprintf(stderr, "%11s %11s\n", "-", "-");
+    }
+    if (rows > LP_TOP)
+        fprintf(stderr, "(%zu more)\n", rows - LP_TOP);
+    if (dropped)
+        fprintf(stderr, "(%ld acquisitions not recorded: a thread's table of %d sites was full)\n",
+                dropped, LP_SITES);
+    free(all);
+}
+
+// ============================================================================
+//                                  REDIRECTS
+// ============================================================================
+#define pthread_mutex_lock(m)              lock_prof_mutex_lock((m), __FILE__, __LINE__)
+#define pthread_mutex_trylock(m)           lock_prof_mutex_trylock((m), __FILE__, __LINE__)
+#define pthread_mutex_unlock(m)            lock_prof_mutex_unlock((m))
+#define pthread_cond_wait(c, m)            lock_prof_cond_wait((c), (m), __FILE__, __LINE__)
+#define pthread_cond_timedwait(c, m, abs)  lock_prof_cond_timedwait((c), (m), (abs), __FILE__, __LINE__)
+
+#endif // LOCK_PROF_H
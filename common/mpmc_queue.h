@@ -0,0 +1,150 @@
+// mpmc_queue.h
+//
+// Bounded lock-free multi-producer / multi-consumer queue (Dmitry Vyukov's
+// per-slot sequence number design).
+// -------------------------------------------------------
+// Header only, instantiated once per item type (like spsc_ring.h):
+//
+//   #define QUEUE_T        long
+//   #define QUEUE_NAME(x)  long_queue_##x
+//   #include "../common/mpmc_queue.h"
+//
+// gives long_queue_t and long_queue_init / _destroy / _push / _pop.
+// QUEUE_T and QUEUE_NAME are #undef'd at the end.
+//
+// Every slot carries a sequence number saying whose turn it is:
+//   seq == pos        free, the producer that claims position pos may fill it
+//   seq == pos + 1    filled, the consumer that claims pos may drain it
+// after draining, the consumer sets seq = pos + capacity, i.e. free for the
+// producer one lap later.
+//
+// A producer reads tail, checks that slot's seq, and claims the position
+// with one CAS on tail; then it writes the item and publishes it with a
+// release store of seq. Consumers do the same on head. Producers only
+// contend with producers and consumers with consumers, and a slot is only
+// touched by the one thread that claimed it, so there are no locks and no
+// allocation per item. Items are stored inline.
+//
+// Not strictly lock-free: a producer preempted between its CAS and its seq
+// store holds up consumers of that one slot (they see it as empty).
+
+#ifndef QUEUE_T
+#error "define QUEUE_T and QUEUE_NAME(x) before including mpmc_queue.h"
+#endif
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+// ============================================================================
+//                                    TYPE
+// ============================================================================
+typedef QUEUE_T QUEUE_NAME(item_t);   // so `const` applies to the item, pointer or not
+
+typedef struct {
+    atomic_size_t seq;
+    QUEUE_T       data;
+} QUEUE_NAME(cell_t);
+
+typedef struct {
+    CACHE_ALIGNED atomic_size_t tail;   // next position to fill (producers)
+    CACHE_ALIGNED atomic_size_t head;   // next position to drain (consumers)
+    CACHE_ALIGNED size_t        mask;   // capacity - 1, read-only
+    QUEUE_NAME(cell_t)         *cells;
+} QUEUE_NAME(t);
+
+// Capacity is rounded up to a power of two (at least 2).
+// Returns 0, or -1 if the cells cannot be allocated.
+static inline int QUEUE_NAME(init)(QUEUE_NAME(t) *q, size_t capacity) {
+    size_t cap = 2;
+    while (cap < capacity)
+        cap <<= 1;
+
+    size_t bytes = (sizeof(QUEUE_NAME(cell_t)) * cap + CACHE_LINE - 1) &
+                   ~(size_t)(CACHE_LINE - 1);
+    q->cells = aligned_alloc(CACHE_LINE, bytes);
+    if (!q->cells)
+        return -1;
+
+    for (size_t i = 0; i < cap; i++)
+        atomic_init(&q->cells[i].seq, i);
+    atomic_init(&q->tail, 0);
+    atomic_init(&q->head, 0);
+    q->mask = cap - 1;
+    return 0;
+}
+
+static inline void QUEUE_NAME(destroy)(QUEUE_NAME(t) *q) {
+    free(q->cells);
+    q->cells = NULL;
+}
+
+// ============================================================================
+//                                    PUSH
+// ----------------------------------------------------------------------------
+// Returns 1, or 0 if the queue is full.
+// ============================================================================
+static inline int QUEUE_NAME(push)(QUEUE_NAME(t) *q, const QUEUE_NAME(item_t) *item) {
+    QUEUE_NAME(cell_t) *c;
+    size_t pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+
+    for (;;) {
+        c = &q->cells[pos & q->mask];
+        size_t   seq  = atomic_load_explicit(&c->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+        if (diff == 0) {
+            // slot free for this lap: try to claim pos
+            if (atomic_compare_exchange_weak_explicit(&q->tail, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+            // lost: pos now holds the current tail, retry
+        } else if (diff < 0) {
+            return 0;   // still holds last lap's item: full
+        } else {
+            pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+        }
+    }
+
+    c->data = *item;
+    atomic_store_explicit(&c->seq, pos + 1, memory_order_release);
+    return 1;
+}
+
+// ============================================================================
+//                                    POP
+// ----------------------------------------------------------------------------
+// Returns 1, or 0 if the queue is empty.
+// ============================================================================
+static inline int QUEUE_NAME(pop)(QUEUE_NAME(t) *q, QUEUE_T *out) {
+    QUEUE_NAME(cell_t) *c;
+    size_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+    for (;;) {
+        c = &q->cells[pos & q->mask];
+        size_t   seq  = atomic_load_explicit(&c->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            return 0;   // not filled yet: empty
+        } else {
+            pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+        }
+    }
+
+    *out = c->data;
+    atomic_store_explicit(&c->seq, pos + q->mask + 1, memory_order_release);
+    return 1;
+}
+
+#undef QUEUE_T
+#undef QUEUE_NAME
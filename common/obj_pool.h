@@ -0,0 +1,280 @@
+// obj_pool.h
+//
+// Fixed-size object pool with per-thread magazine caches (Bonwick's
+// magazine allocator, simplified).
+// -------------------------------------------------------
+// Header only; include it from any assignment directory:
+//   #include "../common/obj_pool.h"
+//
+// Usage:
+//     obj_pool_t pool;
+//     obj_pool_init(&pool, sizeof(item), 100000, nthreads);
+//
+//     obj_cache_t cache;                     // one per thread
+//     obj_cache_init(&pool, &cache);
+//     item *it = obj_alloc(&pool, &cache);   // NULL if the pool is exhausted
+//     ...
+//     obj_free(&pool, &cache, it);           // any thread, any cache
+//     obj_cache_destroy(&pool, &cache);
+//
+// Layout:
+//   arena      all `capacity` objects, allocated once at init
+//   magazine   a small stack of up to OBJ_MAG_SIZE free object pointers
+//   cache      per thread: two magazines, `loaded` and `prev`. alloc/free
+//              push and pop there with no atomics at all
+//   depot      two global lock-free stacks of magazines, full and empty
+//
+// A cache only touches the depot when both its magazines are empty (alloc:
+// trade one empty magazine for a full one) or both are full (free: trade a
+// full one for an empty one), i.e. at most once per OBJ_MAG_SIZE operations.
+// Objects freed by another thread simply go into that thread's magazines,
+// so a producer that allocates and a consumer that frees never share a lock
+// or a cache line per object.
+//
+// The depot stacks are Treiber stacks of magazine indices; the 64-bit head
+// is {32-bit tag, 32-bit index + 1}, and every push/pop bumps the tag so a
+// magazine that is popped and pushed back between a thread's read and its
+// CAS (ABA) can't corrupt the list.
+//
+// Sizing: up to OBJ_MAG_SIZE * 2 objects can sit in each cache, out of
+// reach of other threads. Give `capacity` that much slack per thread.
+// `nthreads` is the number of caches created over the pool's life (one per
+// thread); enough magazines are created that a new cache, and a free with
+// both magazines full, can always find an empty one. If more caches than
+// that are created, the depot can run out of empty magazines: a cache then
+// works with fewer than two, and a free that finds no empty magazine puts the
+// object on a third lock-free stack of loose objects (linked through the
+// objects themselves), where alloc looks before it gives up.
+
+#ifndef OBJ_POOL_H
+#define OBJ_POOL_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+// ============================================================================
+//                                CONFIGURATION
+// ============================================================================
+#define OBJ_MAG_SIZE  64   // object pointers per magazine
+#define OBJ_ALIGN     16   // object alignment (malloc's guarantee on x86-64)
+
+// ============================================================================
+//                                    TYPES
+// ============================================================================
+typedef struct {
+    atomic_uint next;                  // depot link: index + 1, 0 = end
+    int         n;                     // objects held
+    void       *objs[OBJ_MAG_SIZE];
+} obj_mag_t;
+
+typedef struct {
+    CACHE_ALIGNED atomic_uint_least64_t full;    // depot heads: tag | idx+1
+    CACHE_ALIGNED atomic_uint_least64_t empty;
+    CACHE_ALIGNED atomic_uint_least64_t loose;   // tag | object idx+1
+    CACHE_ALIGNED obj_mag_t            *mags;
+    uint32_t                            nmags;
+    size_t                              obj_size;
+    size_t                              capacity;
+    char                               *arena;
+} obj_pool_t;
+
+typedef struct {
+    obj_mag_t *loaded, *prev;
+} CACHE_ALIGNED obj_cache_t;
+
+// ============================================================================
+//                                    DEPOT
+// ============================================================================
+static inline void obj_depot_push(obj_pool_t *p, atomic_uint_least64_t *head, obj_mag_t *m) {
+    uint32_t idx = (uint32_t)(m - p->mags) + 1;
+    uint_least64_t old = atomic_load_explicit(head, memory_order_relaxed);
+    uint_least64_t new;
+    do {
+        atomic_store_explicit(&m->next, (uint32_t)old, memory_order_relaxed);
+        new = ((old >> 32) + 1) << 32 | idx;
+    } while (!atomic_compare_exchange_weak_explicit(head, &old, new,
+                                                    memory_order_release,
+                                                    memory_order_relaxed));
+}
+
+// Returns NULL if the stack is empty.
+static inline obj_mag_t *obj_depot_pop(obj_pool_t *p, atomic_uint_least64_t *head) {
+    uint_least64_t old = atomic_load_explicit(head, memory_order_acquire);
+    uint_least64_t new;
+    obj_mag_t *m;
+    do {
+        uint32_t idx = (uint32_t)old;
+        if (idx == 0)
+            return NULL;
+        m   = &p->mags[idx - 1];
+        new = ((old >> 32) + 1) << 32 |
+              atomic_load_explicit(&m->next, memory_order_relaxed);
+    } while (!atomic_compare_exchange_weak_explicit(head, &old, new,
+                                                    memory_order_acquire,
+                                                    memory_order_acquire));
+    return m;
+}
+
+// ============================================================================
+//                                LOOSE OBJECTS
+// ----------------------------------------------------------------------------
+// Same tagged-head scheme as the depot, with arena indices. The link lives
+// in the object's first bytes (objects are at least OBJ_ALIGN bytes). A pop
+// may read the link of an object another thread has just taken and is
+// writing; the tag then makes its CAS fail and the value is never used.
+// ============================================================================
+static inline void obj_loose_push(obj_pool_t *p, void *obj) {
+    uint32_t idx = (uint32_t)(((char *)obj - p->arena) / p->obj_size) + 1;
+    atomic_uint *link = obj;
+    uint_least64_t old = atomic_load_explicit(&p->loose, memory_order_relaxed);
+    uint_least64_t new;
+    do {
+        atomic_store_explicit(link, (uint32_t)old, memory_order_relaxed);
+        new = ((old >> 32) + 1) << 32 | idx;
+    } while (!atomic_compare_exchange_weak_explicit(&p->loose, &old, new,
+                                                    memory_order_release,
+                                                    memory_order_relaxed));
+}
+
+// Returns NULL if there are none.
+static inline void *obj_loose_pop(obj_pool_t *p) {
+    uint_least64_t old = atomic_load_explicit(&p->loose, memory_order_acquire);
+    uint_least64_t new;
+    char *obj;
+    do {
+        uint32_t idx = (uint32_t)old;
+        if (idx == 0)
+            return NULL;
+        obj = p->arena + p->obj_size * (idx - 1);
+        new = ((old >> 32) + 1) << 32 |
+              atomic_load_explicit((atomic_uint *)obj, memory_order_relaxed);
+    } while (!atomic_compare_exchange_weak_explicit(&p->loose, &old, new,
+                                                    memory_order_acquire,
+                                                    memory_order_acquire));
+    return obj;
+}
+
+// ============================================================================
+//                                 POOL SETUP
+// ----------------------------------------------------------------------------
+// Returns 0, or -1 if memory cannot be allocated.
+// ============================================================================
+static inline int obj_pool_init(obj_pool_t *p, size_t obj_size, size_t capacity, int nthreads) {
+    p->obj_size = (obj_size + OBJ_ALIGN - 1) & ~(size_t)(OBJ_ALIGN - 1);
+    p->capacity = capacity;
+
+    size_t full_mags = (capacity + OBJ_MAG_SIZE - 1) / OBJ_MAG_SIZE;
+    p->nmags = (uint32_t)(full_mags + 3 * (size_t)nthreads + 1);
+
+    size_t arena_bytes = (p->obj_size * capacity + CACHE_LINE - 1) & ~(size_t)(CACHE_LINE - 1);
+    p->arena = aligned_alloc(CACHE_LINE, arena_bytes ? arena_bytes : CACHE_LINE);
+    p->mags  = malloc(sizeof(obj_mag_t) * p->nmags);
+    if (!p->arena || !p->mags) {
+        free(p->arena);
+        free(p->mags);
+        return -1;
+    }
+
+    atomic_init(&p->full, 0);
+    atomic_init(&p->empty, 0);
+    atomic_init(&p->loose, 0);
+
+    // fill magazines with the arena's objects; the rest start empty
+    size_t next_obj = 0;
+    for (uint32_t i = 0; i < p->nmags; i++) {
+        obj_mag_t *m = &p->mags[i];
+        atomic_init(&m->next, 0);
+        m->n = 0;
+        while (m->n < OBJ_MAG_SIZE && next_obj < capacity)
+            m->objs[m->n++] = p->arena + p->obj_size * next_obj++;
+        obj_depot_push(p, m->n ? &p->full : &p->empty, m);
+    }
+    return 0;
+}
+
+// Every cache must have been destroyed (or simply not be used again).
+static inline void obj_pool_destroy(obj_pool_t *p) {
+    free(p->mags);
+    free(p->arena);
+}
+
+// ============================================================================
+//                                PER-THREAD CACHE
+// ============================================================================
+// Either magazine may be NULL if the depot had no empty one left (more
+// caches than the pool was sized for); alloc and free cope with that.
+static inline void obj_cache_init(obj_pool_t *p, obj_cache_t *c) {
+    c->loaded = obj_depot_pop(p, &p->empty);
+    c->prev   = obj_depot_pop(p, &p->empty);
+}
+
+// Hands the cache's objects back to the depot for other threads.
+static inline void obj_cache_destroy(obj_pool_t *p, obj_cache_t *c) {
+    // top up loaded from prev so at most one partial magazine goes back
+    while (c->loaded && c->prev && c->prev->n > 0 && c->loaded->n < OBJ_MAG_SIZE)
+        c->loaded->objs[c->loaded->n++] = c->prev->objs[--c->prev->n];
+
+    obj_mag_t *ms[2] = { c->loaded, c->prev };
+    for (int i = 0; i < 2; i++)
+        if (ms[i])
+            obj_depot_push(p, ms[i]->n ? &p->full : &p->empty, ms[i]);
+    c->loaded = c->prev = NULL;
+}
+
+// ============================================================================
+//                                 ALLOC / FREE
+// ============================================================================
+
+// Returns an object, or NULL if the depot has no objects left.
+static inline void *obj_alloc(obj_pool_t *p, obj_cache_t *c) {
+    if (c->loaded && c->loaded->n > 0)
+        return c->loaded->objs[--c->loaded->n];
+
+    if (c->prev && c->prev->n > 0) {
+        obj_mag_t *t = c->loaded;
+        c->loaded = c->prev;
+        c->prev   = t;
+        return c->loaded->objs[--c->loaded->n];
+    }
+
+    // both empty (or missing): swap one for a full magazine from the depot
+    obj_mag_t *m = obj_depot_pop(p, &p->full);
+    if (!m)
+        return obj_loose_pop(p);
+    if (c->prev)
+        obj_depot_push(p, &p->empty, c->prev);
+    c->prev   = c->loaded;
+    c->loaded = m;
+    return c->loaded->objs[--c->loaded->n];
+}
+
+static inline void obj_free(obj_pool_t *p, obj_cache_t *c, void *obj) {
+    if (c->loaded && c->loaded->n < OBJ_MAG_SIZE) {
+        c->loaded->objs[c->loaded->n++] = obj;
+        return;
+    }
+
+    if (c->prev && c->prev->n == 0) {
+        obj_mag_t *t = c->loaded;
+        c->loaded = c->prev;
+        c->prev   = t;
+    } else {
+        // both full (or missing): take an empty one, park a full one
+        obj_mag_t *m = obj_depot_pop(p, &p->empty);
+        if (!m) {
+            obj_loose_push(p, obj);    // pool oversubscribed: no magazine free
+            return;
+        }
+        if (c->prev)
+            obj_depot_push(p, &p->full, c->prev);
+        c->prev   = c->loaded;
+        c->loaded = m;
+    }
+    c->loaded->objs[c->loaded->n++] = obj;
+}
+
+#endif // OBJ_POOL_H
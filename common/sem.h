@@ -0,0 +1,263 @@
+// sem.h
+//
+// FIFO, direct-handoff counting semaphore (the CUSTOM SEMAPHORE from
+// class-examples/semaphore.c).
+// -------------------------------------------------------
+// Header only; include it from any assignment directory:
+//   #include "../common/sem.h"
+//
+// Needs _GNU_SOURCE (or _DEFAULT_SOURCE) defined before the first #include
+// of the including file, for syscall().
+//
+// The function names match POSIX (sem_wait / sem_post / sem_trywait /
+// sem_timedwait) but the type does not, so don't include <semaphore.h> in
+// the same file.
+//
+//   value    resources available; only ever > 0 while nobody is queued
+//   head     oldest waiter, tail newest (doubly linked, nodes live on the
+//            waiters' stacks)
+//   guard    tiny futex lock around value and the queue
+//
+// sem_post() never puts a resource back while someone is queued: it hands
+// it straight to the oldest waiter and wakes only that thread, on that
+// thread's own futex word. So there is no thundering herd, a poster that
+// immediately calls sem_wait() again can't barge ahead of sleepers, and
+// waiters are served strictly in arrival order.
+//
+// Costs: an uncontended wait or post is a guard acquire/release (two atomics,
+// no syscall). A wait that has to sleep costs one FUTEX_WAIT, and handing a
+// resource to a sleeper one FUTEX_WAKE. Spurious futex returns just loop.
+
+#ifndef SEM_H
+#define SEM_H
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <time.h>
+
+#include "bench.h"
+#include "futex.h"
+
+// ============================================================================
+//                                CONFIGURATION
+// ============================================================================
+#define SEM_GUARD_SPIN 100   // guard: spins before sleeping on it
+
+// ============================================================================
+//                                    TYPES
+// ============================================================================
+typedef struct sem_waiter {
+    atomic_int         granted;   // futex word: 0 = waiting, 1 = resource ours
+    int                queued;    // still on the waitlist (guard held)
+    struct sem_waiter *prev, *next;
+} sem_waiter;
+
+typedef struct {
+    atomic_int  guard;            // 0 free, 1 held, 2 held + sleepers
+    int         value;            // Resources
+    sem_waiter *head, *tail;      // Waitlist, oldest first
+} semaphore;
+
+static inline void sem_init_value(semaphore *s, int value) {
+    atomic_init(&s->guard, 0);
+    s->value = value;
+    s->head  = NULL;
+    s->tail  = NULL;
+}
+
+// ============================================================================
+//                                    GUARD
+// ----------------------------------------------------------------------------
+// Two-phase futex lock: held for a handful of instructions, so spin first.
+// ============================================================================
+static inline int sem_guard_cas(semaphore *s, int expected, int desired) {
+    atomic_compare_exchange_strong_explicit(&s->guard, &expected, desired,
+                                            memory_order_acquire,
+                                            memory_order_relaxed);
+    return expected;
+}
+
+static inline void sem_guard_lock(semaphore *s) {
+    int c = sem_guard_cas(s, 0, 1);
+    for (int i = 0; i < SEM_GUARD_SPIN && c != 0; i++) {
+        cpu_relax();
+        c = sem_guard_cas(s, 0, 1);
+    }
+    if (c == 0)
+        return;
+
+    c = atomic_exchange_explicit(&s->guard, 2, memory_order_acquire);
+    while (c != 0) {
+        futex_wait_private(&s->guard, 2);
+        c = atomic_exchange_explicit(&s->guard, 2, memory_order_acquire);
+    }
+}
+
+static inline void sem_guard_unlock(semaphore *s) {
+    if (atomic_fetch_sub_explicit(&s->guard, 1, memory_order_release) != 1) {
+        atomic_store_explicit(&s->guard, 0, memory_order_release);
+        futex_wake_private(&s->guard, 1);
+    }
+}
+
+// ============================================================================
+//                                  WAITLIST
+// ----------------------------------------------------------------------------
+// Guard held for all of these.
+// ============================================================================
+static inline void sem_enqueue(semaphore *s, sem_waiter *w) {
+    atomic_init(&w->granted, 0);
+    w->queued = 1;
+    w->next = NULL;
+    w->prev = s->tail;
+    if (s->tail)
+        s->tail->next = w;
+    else
+        s->head = w;
+    s->tail = w;
+}
+
+static inline void sem_unlink(semaphore *s, sem_waiter *w) {
+    if (w->prev) w->prev->next = w->next; else s->head = w->next;
+    if (w->next) w->next->prev = w->prev; else s->tail = w->prev;
+}
+
+// The waiter may return (and its stack node vanish) as soon as `granted` is
+// set, so read nothing from it after that; a FUTEX_WAKE on a dead address is
+// harmless (at worst a spurious wakeup for whoever reuses it).
+static inline void sem_grant(sem_waiter *w) {
+    atomic_store_explicit(&w->granted, 1, memory_order_release);
+    futex_wake_private(&w->granted, 1);
+}
+
+// ============================================================================
+//                                 SEM_TRYWAIT
+// ----------------------------------------------------------------------------
+// Takes a resource only if one is free and nobody is queued ahead.
+// Returns 0, or -1 with errno = EAGAIN.
+// ============================================================================
+static inline int sem_trywait(semaphore *s) {
+    sem_guard_lock(s);
+    if (s->value > 0) {            // value > 0 implies the queue is empty
+        s->value--;
+        sem_guard_unlock(s);
+        return 0;
+    }
+    sem_guard_unlock(s);
+    errno = EAGAIN;
+    return -1;
+}
+
+// ============================================================================
+//                                SEM_TIMEDWAIT
+// ----------------------------------------------------------------------------
+// Decrement Semaphore, blocking until `abs_timeout` (CLOCK_REALTIME, as in
+// POSIX). NULL waits forever.
+// Returns 0, or -1 with errno = ETIMEDOUT.
+// ============================================================================
+static inline int sem_timedwait(semaphore *s, const struct timespec *abs_timeout) {
+    sem_guard_lock(s);
+    if (s->value > 0) {
+        s->value--;
+        sem_guard_unlock(s);
+        return 0;                                   // served immediately
+    }
+
+    sem_waiter me;
+    sem_enqueue(s, &me);                            // Add to waitlist
+    sem_guard_unlock(s);
+
+    while (!atomic_load_explicit(&me.granted, memory_order_acquire)) {
+        if (!abs_timeout) {
+            futex_wait_private(&me.granted, 0);     // Block
+            continue;
+        }
+
+        struct timespec now, rel;
+        clock_gettime(CLOCK_REALTIME, &now);
+        rel.tv_sec  = abs_timeout->tv_sec - now.tv_sec;
+        rel.tv_nsec = abs_timeout->tv_nsec - now.tv_nsec;
+        if (rel.tv_nsec < 0) {
+            rel.tv_nsec += 1000000000L;
+            rel.tv_sec--;
+        }
+        if (rel.tv_sec >= 0) {
+            futex_timedwait(&me.granted, 0, &rel, 0);
+            continue;
+        }
+
+        // timed out: leave the queue, unless a post already took us off it
+        // (then the resource is ours and `granted` is about to be set)
+        sem_guard_lock(s);
+        if (!me.queued) {
+            sem_guard_unlock(s);
+            while (!atomic_load_explicit(&me.granted, memory_order_acquire))
+                futex_wait_private(&me.granted, 0);
+            break;
+        }
+        sem_unlink(s, &me);
+        sem_guard_unlock(s);
+        errno = ETIMEDOUT;
+        return -1;
+    }
+    return 0;                                       // handed to us by a post
+}
+
+// ============================================================================
+//                                   SEM_WAIT
+// ----------------------------------------------------------------------------
+// Decrement Semaphore, possibly blocks.
+// Calling thread holds 1 resource on return.
+// ============================================================================
+static inline int sem_wait(semaphore *s) {
+    return sem_timedwait(s, NULL);
+}
+
+// ============================================================================
+//                                  SEM_POST_N
+// ----------------------------------------------------------------------------
+// Releases n resources in one call: the n oldest waiters each get one
+// directly (exactly one wake each), whatever is left goes back to value.
+// ============================================================================
+static inline int sem_post_n(semaphore *s, int n) {
+    sem_guard_lock(s);
+    sem_waiter *granted = s->head;  // the n oldest, still chained by ->next
+    sem_waiter *last = NULL;
+    for (; n > 0 && s->head; n--) {
+        last         = s->head;
+        last->queued = 0;
+        s->head      = last->next;
+    }
+    if (last) {
+        last->next = NULL;          // cut the granted run off the queue
+        if (s->head)
+            s->head->prev = NULL;
+        else
+            s->tail = NULL;
+    } else {
+        granted = NULL;
+    }
+    s->value += n;
+    sem_guard_unlock(s);
+
+    // wake oldest first, outside the guard; grab ->next before the waiter
+    // can leave
+    while (granted) {
+        sem_waiter *next = granted->next;
+        sem_grant(granted);
+        granted = next;
+    }
+    return 0;
+}
+
+// ============================================================================
+//                                   SEM_POST
+// ----------------------------------------------------------------------------
+// Increment Semaphore (Release Resource).
+// ============================================================================
+static inline int sem_post(semaphore *s) {
+    return sem_post_n(s, 1);
+}
+
+#endif // SEM_H
@@ -0,0 +1,191 @@
+// shm_ring.h
+//
+// Cross-process single-producer / single-consumer ring of variable-length
+// records, for a shm_open()/MAP_SHARED segment.
+// -------------------------------------------------------
+// Header only; include it from any assignment directory:
+//   #include "../common/shm_ring.h"
+//
+// Needs _GNU_SOURCE (or _DEFAULT_SOURCE) defined before the first #include
+// of the including file, for syscall().
+//
+// The circular buffer from class-examples/circular_buffer.c (spsc_ring.h),
+// reworked for processes:
+//   - plain data, no pointers: the header and the bytes live in the segment,
+//     valid at any address in any process
+//   - a byte ring instead of fixed items: each record is a 4-byte length
+//     followed by the payload, padded to 4 bytes, and may wrap round the end
+//   - tail (bytes written) and head (bytes read) are free-running 32-bit
+//     counters on separate cache lines, and double as the futex words
+//
+// Nobody makes a system call while data flows. A consumer that finds the
+// ring empty spins briefly, then raises cons_waiting and sleeps on tail;
+// the producer only calls FUTEX_WAKE if it sees that flag after publishing.
+// Full works the same way the other way round (prod_waiting, head).
+// Flag store and index re-check are both seq_cst, so a wakeup can't slip
+// between a side's last check and its sleep.
+//
+// One sending process and one receiving process at a time.
+
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "bench.h"
+#include "futex.h"
+
+// ============================================================================
+//                                CONFIGURATION
+// ============================================================================
+#define SHM_RING_SPIN  200   // empty/full re-checks before sleeping
+#define SHM_RING_HDR   4     // length prefix per record
+
+// ============================================================================
+//                                    TYPE
+// ============================================================================
+typedef struct {
+    CACHE_ALIGNED atomic_int tail;           // bytes written (producer)
+    atomic_int               prod_waiting;   // producer asleep on head
+    CACHE_ALIGNED atomic_int head;           // bytes read (consumer)
+    atomic_int               cons_waiting;   // consumer asleep on tail
+    CACHE_ALIGNED uint32_t   size;           // data bytes, power of two
+    uint32_t                 mask;
+    atomic_int               ready;          // set last by shm_ring_init
+    CACHE_ALIGNED char       data[];
+} shm_ring;
+
+// Segment size for a ring with `capacity` data bytes (a power of two).
+static inline size_t shm_ring_bytes(uint32_t capacity) {
+    return sizeof(shm_ring) + capacity;
+}
+
+// Call once, from the process that creates the segment.
+// `capacity` must be a power of two and match shm_ring_bytes().
+static inline void shm_ring_init(shm_ring *r, uint32_t capacity) {
+    atomic_init(&r->tail, 0);
+    atomic_init(&r->head, 0);
+    atomic_init(&r->prod_waiting, 0);
+    atomic_init(&r->cons_waiting, 0);
+    r->size = capacity;
+    r->mask = capacity - 1;
+    atomic_store_explicit(&r->ready, 1, memory_order_release);
+}
+
+// For the process that opens an existing segment: has it been initialised?
+static inline int shm_ring_ready(shm_ring *r) {
+    return atomic_load_explicit(&r->ready, memory_order_acquire);
+}
+
+// Largest record shm_ring_send() accepts.
+static inline size_t shm_ring_max_record(const shm_ring *r) {
+    return r->size - SHM_RING_HDR;
+}
+
+// ============================================================================
+//                                   HELPERS
+// ============================================================================
+static inline uint32_t shm_ring_pad(size_t len) {
+    return (uint32_t)((len + 3) & ~(size_t)3);
+}
+
+static inline void shm_ring_copy_in(shm_ring *r, uint32_t pos, const void *src, size_t n) {
+    uint32_t at    = pos & r->mask;
+    size_t   first = n < r->size - at ? n : r->size - at;
+    memcpy(r->data + at, src, first);
+    memcpy(r->data, (const char *)src + first, n - first);
+}
+
+static inline void shm_ring_copy_out(const shm_ring *r, uint32_t pos, void *dst, size_t n) {
+    uint32_t at    = pos & r->mask;
+    size_t   first = n < r->size - at ? n : r->size - at;
+    memcpy(dst, r->data + at, first);
+    memcpy((char *)dst + first, r->data, n - first);
+}
+
+// Spins, then sleeps on *idx while it still reads `seen` (and the flag is
+// up). The other side clears the flag and wakes us once it moves *idx.
+static inline void shm_ring_block(atomic_int *idx, int seen, atomic_int *flag) {
+    for (int i = 0; i < SHM_RING_SPIN; i++) {
+        if (atomic_load_explicit(idx, memory_order_acquire) != seen)
+            return;
+        cpu_relax();
+    }
+    atomic_store(flag, 1);
+    if (atomic_load(idx) == seen)
+        futex_wait(idx, seen);
+    atomic_store_explicit(flag, 0, memory_order_relaxed);
+}
+
+// After moving *idx: wake the other side if it went to sleep.
+static inline void shm_ring_kick(atomic_int *idx, atomic_int *flag) {
+    if (atomic_load(flag) && atomic_exchange(flag, 0))
+        futex_wake(idx, 1);
+}
+
+// ============================================================================
+//                                SHM_RING_SEND
+// ----------------------------------------------------------------------------
+// Copies one record (len may be 0) into the ring, blocking while full.
+// Returns 0, or -1 with errno = EMSGSIZE if it can never fit.
+// ============================================================================
+static inline int shm_ring_send(shm_ring *r, const void *buf, size_t len) {
+    if (len > shm_ring_max_record(r)) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    uint32_t need = SHM_RING_HDR + shm_ring_pad(len);
+    uint32_t tail = (uint32_t)atomic_load_explicit(&r->tail, memory_order_relaxed);
+
+    for (;;) {
+        int head = atomic_load_explicit(&r->head, memory_order_acquire);
+        if (r->size - (tail - (uint32_t)head) >= need)
+            break;
+        shm_ring_block(&r->head, head, &r->prod_waiting);   // full
+    }
+
+    uint32_t hdr = (uint32_t)len;
+    shm_ring_copy_in(r, tail, &hdr, SHM_RING_HDR);
+    shm_ring_copy_in(r, tail + SHM_RING_HDR, buf, len);
+
+    atomic_store(&r->tail, (int)(tail + need));   // publish
+    shm_ring_kick(&r->tail, &r->cons_waiting);
+    return 0;
+}
+
+// ============================================================================
+//                                SHM_RING_RECV
+// ----------------------------------------------------------------------------
+// Takes the next record, blocking while empty.
+// Returns its length, or -1 with errno = EMSGSIZE (record left in place) if
+// it is longer than cap.
+// ============================================================================
+static inline ssize_t shm_ring_recv(shm_ring *r, void *buf, size_t cap) {
+    uint32_t head = (uint32_t)atomic_load_explicit(&r->head, memory_order_relaxed);
+
+    for (;;) {
+        int tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+        if ((uint32_t)tail != head)
+            break;
+        shm_ring_block(&r->tail, tail, &r->cons_waiting);   // empty
+    }
+
+    uint32_t len;
+    shm_ring_copy_out(r, head, &len, SHM_RING_HDR);
+    if (len > cap) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    shm_ring_copy_out(r, head + SHM_RING_HDR, buf, len);
+
+    atomic_store(&r->head, (int)(head + SHM_RING_HDR + shm_ring_pad(len)));   // free it
+    shm_ring_kick(&r->head, &r->prod_waiting);
+    return (ssize_t)len;
+}
+
+#endif // SHM_RING_H
@@ -0,0 +1,202 @@
+// shm_sem.h
+//
+// Process-shared, owner-robust counting semaphore.
+// -------------------------------------------------------
+// Header only; include it from any assignment directory:
+//   #include "../common/shm_sem.h"
+//
+// Needs _GNU_SOURCE (or _DEFAULT_SOURCE) defined before the first #include
+// of the including file, for syscall().
+//
+// Same idea as sem.h, but meant to be placed in a shm_open()/MAP_SHARED
+// segment and used by separate processes:
+//   - futexes are used without FUTEX_PRIVATE_FLAG, so the kernel matches
+//     waiters by the physical page, not by one process's address
+//   - every process that takes a unit records its pid in a holder slot;
+//     sleeping waiters wake up every SHM_SEM_CHECK_MS and, if a recorded
+//     holder no longer exists, take its unit over directly (the unit never
+//     goes back through `value`, so nobody else can grab it). A crashed
+//     holder therefore can't wedge everyone, and the waiter that inherits its
+//     unit - and only that waiter - is told so with EOWNERDEAD (like a robust
+//     pthread mutex) because whatever the dead process was protecting may be
+//     half-updated.
+//
+// For signalling (one process posts, another waits, like the full/empty
+// pair of a bounded buffer) the waiter uses shm_sem_wait_event(), which does
+// not register it as a holder: it consumed a signal, it doesn't hold a lock.
+// Posting without holding is fine; it just doesn't clear a holder slot.
+//
+// Holder slots are per unit, up to SHM_SEM_MAX_HOLDERS; units taken beyond
+// that are not tracked. A dead holder is noticed once kill(pid, 0) fails,
+// i.e. after its parent has reaped it; pid reuse can hide a death until the
+// new process with that pid exits. Those are the usual caveats.
+
+#ifndef SHM_SEM_H
+#define SHM_SEM_H
+
+#include <errno.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "futex.h"
+
+// ============================================================================
+//                                CONFIGURATION
+// ============================================================================
+#define SHM_SEM_MAX_HOLDERS 16
+#define SHM_SEM_CHECK_MS    100   // how often sleepers look for dead holders
+
+// ============================================================================
+//                                    TYPE
+// ----------------------------------------------------------------------------
+// Plain data, no pointers: valid at any address in any process.
+// ============================================================================
+typedef struct {
+    atomic_int value;                          // units available
+    atomic_int waiters;                        // sleeping or about to
+    atomic_int holders[SHM_SEM_MAX_HOLDERS];   // pid per held unit, 0 = free
+} shm_semaphore;
+
+// Call once, from the process that creates the segment.
+static inline void shm_sem_init(shm_semaphore *s, int value) {
+    atomic_init(&s->value, value);
+    atomic_init(&s->waiters, 0);
+    for (int i = 0; i < SHM_SEM_MAX_HOLDERS; i++)
+        atomic_init(&s->holders[i], 0);
+}
+
+// ============================================================================
+//                                   HELPERS
+// ============================================================================
+static inline int shm_sem_trytake(shm_semaphore *s) {
+    int v = atomic_load_explicit(&s->value, memory_order_relaxed);
+    while (v > 0) {
+        if (atomic_compare_exchange_weak_explicit(&s->value, &v, v - 1,
+                                                  memory_order_acquire,
+                                                  memory_order_relaxed))
+            return 1;
+    }
+    return 0;
+}
+
+static inline void shm_sem_add_holder(shm_semaphore *s) {
+    int me = (int)getpid();
+    for (int i = 0; i < SHM_SEM_MAX_HOLDERS; i++) {
+        int expected = 0;
+        if (atomic_compare_exchange_strong(&s->holders[i], &expected, me))
+            return;
+    }
+}
+
+static inline void shm_sem_drop_holder(shm_semaphore *s) {
+    int me = (int)getpid();
+    for (int i = 0; i < SHM_SEM_MAX_HOLDERS; i++) {
+        int expected = me;
+        if (atomic_compare_exchange_strong(&s->holders[i], &expected, 0))
+            return;
+    }
+}
+
+static inline void shm_sem_release_unit(shm_semaphore *s) {
+    atomic_fetch_add(&s->value, 1);
+    if (atomic_load(&s->waiters) > 0)
+        futex_wake(&s->value, 1);
+}
+
+// Takes over the unit of one holder that no longer exists: its slot goes to
+// the caller (with `track`) or is cleared. Returns 1 if a unit was inherited.
+// Other dead holders are left for the next pass, so each inherited unit
+// reaches exactly one waiter.
+static inline int shm_sem_inherit_dead(shm_semaphore *s, int track) {
+    int me = track ? (int)getpid() : 0;
+    for (int i = 0; i < SHM_SEM_MAX_HOLDERS; i++) {
+        int pid = atomic_load(&s->holders[i]);
+        if (pid <= 0 || kill(pid, 0) == 0 || errno != ESRCH)
+            continue;
+        if (atomic_compare_exchange_strong(&s->holders[i], &pid, me))
+            return 1;
+    }
+    return 0;
+}
+
+// ============================================================================
+//                                 SHM_SEM_TAKE
+// ----------------------------------------------------------------------------
+// Takes one unit, sleeping up to timeout_ms (-1 = forever); with `track` the
+// caller is recorded as a holder.
+// Returns 0, EOWNERDEAD (got the unit of a holder that died), or ETIMEDOUT.
+// ============================================================================
+static inline int shm_sem_take(shm_semaphore *s, long timeout_ms, int track) {
+    if (shm_sem_trytake(s)) {
+        if (track)
+            shm_sem_add_holder(s);
+        return 0;                                      // fast path
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    atomic_fetch_add(&s->waiters, 1);
+    for (;;) {
+        if (shm_sem_trytake(s))
+            break;
+
+        long waited = 0;
+        if (timeout_ms >= 0) {
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            waited = (now.tv_sec - start.tv_sec) * 1000 +
+                     (now.tv_nsec - start.tv_nsec) / 1000000;
+            if (waited >= timeout_ms) {
+                atomic_fetch_sub(&s->waiters, 1);
+                return ETIMEDOUT;
+            }
+        }
+
+        long nap = SHM_SEM_CHECK_MS;
+        if (timeout_ms >= 0 && timeout_ms - waited < nap)
+            nap = timeout_ms - waited;
+        struct timespec rel = { nap / 1000, (nap % 1000) * 1000000L };
+
+        if (futex_timedwait(&s->value, 0, &rel, 1) == -1 && errno == ETIMEDOUT &&
+            shm_sem_inherit_dead(s, track)) {
+            atomic_fetch_sub(&s->waiters, 1);
+            return EOWNERDEAD;                         // already recorded
+        }
+    }
+    atomic_fetch_sub(&s->waiters, 1);
+
+    if (track)
+        shm_sem_add_holder(s);
+    return 0;
+}
+
+// Holds a unit until shm_sem_post(). Returns 0 or EOWNERDEAD.
+static inline int shm_sem_wait(shm_semaphore *s) {
+    return shm_sem_take(s, -1, 1);
+}
+
+// As shm_sem_wait, giving up after timeout_ms with ETIMEDOUT.
+static inline int shm_sem_timedwait(shm_semaphore *s, long timeout_ms) {
+    return shm_sem_take(s, timeout_ms, 1);
+}
+
+// Consumes a signal posted by another process; not recorded as a holder.
+// Returns 0 or ETIMEDOUT (timeout_ms = -1 waits forever).
+static inline int shm_sem_wait_event(shm_semaphore *s, long timeout_ms) {
+    int rc = shm_sem_take(s, timeout_ms, 0);
+    return rc == EOWNERDEAD ? 0 : rc;
+}
+
+// ============================================================================
+//                                 SHM_SEM_POST
+// ============================================================================
+static inline int shm_sem_post(shm_semaphore *s) {
+    shm_sem_drop_holder(s);
+    shm_sem_release_unit(s);
+    return 0;
+}
+
+#endif // SHM_SEM_H
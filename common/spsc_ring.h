@@ -0,0 +1,183 @@
+// spsc_ring.h
+//
+// Lock-free single-producer / single-consumer ring buffer.
+// -------------------------------------------------------
+// Header only, instantiated once per item type (like sem_bench_body.h):
+//
+//   #define RING_T        item            // stored by value, inline
+//   #define RING_NAME(x)  item_ring_##x   // prefixes the type and functions
+//   #include "../common/spsc_ring.h"
+//
+// gives item_ring_t and item_ring_init / _destroy / _push / _pop /
+// _push_n / _pop_n / _size. RING_T and RING_NAME are #undef'd at the end, so
+// the header can be included again for another type.
+//
+// Exactly one thread pushes and exactly one thread pops. Then no locks and
+// no read-modify-write atomics are needed:
+//   tail   next slot to fill  - written only by the producer
+//   head   next slot to drain - written only by the consumer
+// Both are free-running counters; the slot is `index & mask` (capacity is a
+// power of two, so no division and no "one slot always empty" trick).
+//
+// The producer writes the item, then publishes it with a release store of
+// tail; the consumer's acquire load of tail makes the item visible. Same in
+// reverse for head, which hands the slot back for reuse.
+//
+// head and tail sit on separate cache lines so the two threads don't
+// invalidate each other on every operation. Each side also keeps a private
+// copy of the other side's index and only re-reads the shared one when its
+// copy says the ring is full (producer) or empty (consumer).
+//
+// The batched calls move up to n items with one index load and one index
+// store, which is where the bulk of the throughput comes from.
+
+#ifndef RING_T
+#error "define RING_T and RING_NAME(x) before including spsc_ring.h"
+#endif
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+
+// ============================================================================
+//                                    TYPE
+// ============================================================================
+typedef RING_T RING_NAME(item_t);   // so `const` applies to the item, pointer or not
+
+typedef struct {
+    // producer's line
+    CACHE_ALIGNED atomic_size_t tail;
+    size_t                      head_cache;   // producer's last view of head
+
+    // consumer's line
+    CACHE_ALIGNED atomic_size_t head;
+    size_t                      tail_cache;   // consumer's last view of tail
+
+    // read-only after init
+    CACHE_ALIGNED size_t mask;                // capacity - 1
+    RING_T *slots;
+} RING_NAME(t);
+
+// Capacity is rounded up to a power of two (at least 2).
+// Returns 0, or -1 if the slots cannot be allocated.
+static inline int RING_NAME(init)(RING_NAME(t) *r, size_t capacity) {
+    size_t cap = 2;
+    while (cap < capacity)
+        cap <<= 1;
+
+    size_t bytes = (sizeof(RING_T) * cap + CACHE_LINE - 1) & ~(size_t)(CACHE_LINE - 1);
+    r->slots = aligned_alloc(CACHE_LINE, bytes);
+    if (!r->slots)
+        return -1;
+
+    atomic_init(&r->tail, 0);
+    atomic_init(&r->head, 0);
+    r->head_cache = 0;
+    r->tail_cache = 0;
+    r->mask       = cap - 1;
+    return 0;
+}
+
+static inline void RING_NAME(destroy)(RING_NAME(t) *r) {
+    free(r->slots);
+    r->slots = NULL;
+}
+
+// ============================================================================
+//                                  PRODUCER
+// ============================================================================
+
+// Pushes up to n items; returns how many fit (0 = full).
+static inline size_t RING_NAME(push_n)(RING_NAME(t) *r, const RING_NAME(item_t) *items, size_t n) {
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    size_t cap  = r->mask + 1;
+
+    if (cap - (tail - r->head_cache) < n)
+        r->head_cache = atomic_load_explicit(&r->head, memory_order_acquire);
+    size_t room = cap - (tail - r->head_cache);
+    if (n > room)
+        n = room;
+    if (n == 0)
+        return 0;
+
+    // copy in at most two runs: up to the end of the array, then the wrap
+    size_t at    = tail & r->mask;
+    size_t first = (n < cap - at) ? n : cap - at;
+    memcpy(&r->slots[at], items, first * sizeof(RING_T));
+    memcpy(&r->slots[0], items + first, (n - first) * sizeof(RING_T));
+
+    atomic_store_explicit(&r->tail, tail + n, memory_order_release);
+    return n;
+}
+
+// Returns 1, or 0 if the ring is full.
+static inline int RING_NAME(push)(RING_NAME(t) *r, const RING_NAME(item_t) *item) {
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+
+    if (tail - r->head_cache > r->mask) {
+        r->head_cache = atomic_load_explicit(&r->head, memory_order_acquire);
+        if (tail - r->head_cache > r->mask)
+            return 0;
+    }
+    r->slots[tail & r->mask] = *item;
+    atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+// ============================================================================
+//                                  CONSUMER
+// ============================================================================
+
+// Pops up to max items into out; returns how many (0 = empty).
+static inline size_t RING_NAME(pop_n)(RING_NAME(t) *r, RING_T *out, size_t max) {
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+
+    if (r->tail_cache - head < max)
+        r->tail_cache = atomic_load_explicit(&r->tail, memory_order_acquire);
+    size_t n = r->tail_cache - head;
+    if (n > max)
+        n = max;
+    if (n == 0)
+        return 0;
+
+    size_t cap   = r->mask + 1;
+    size_t at    = head & r->mask;
+    size_t first = (n < cap - at) ? n : cap - at;
+    memcpy(out, &r->slots[at], first * sizeof(RING_T));
+    memcpy(out + first, &r->slots[0], (n - first) * sizeof(RING_T));
+
+    atomic_store_explicit(&r->head, head + n, memory_order_release);
+    return n;
+}
+
+// Returns 1, or 0 if the ring is empty.
+static inline int RING_NAME(pop)(RING_NAME(t) *r, RING_T *out) {
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+
+    if (head == r->tail_cache) {
+        r->tail_cache = atomic_load_explicit(&r->tail, memory_order_acquire);
+        if (head == r->tail_cache)
+            return 0;
+    }
+    *out = r->slots[head & r->mask];
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+    return 1;
+}
+
+// ============================================================================
+//                                   EITHER
+// ============================================================================
+
+// Items currently queued. Exact from a single thread; from the producer or
+// consumer while the other is running it is a snapshot.
+static inline size_t RING_NAME(size)(RING_NAME(t) *r) {
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    size_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+    return tail - head;
+}
+
+#undef RING_T
+#undef RING_NAME
@@ -0,0 +1,201 @@
+// trace.h
+//
+// Per-thread binary event log, written out as Chrome trace / Perfetto JSON.
+// -------------------------------------------------------
+// Header only; include it from any assignment directory:
+//   #include "../common/trace.h"
+//
+// Usage:
+//     trace_init("trace.json", 4096);         // once, before the threads
+//     trace_thread("philosopher %d", i);      // once in each thread
+//     trace_begin("eating");  ...  trace_end("eating");
+//     trace_instant("woke", arg);
+// At exit every buffer is decoded into trace.json; open it in
+// ui.perfetto.dev or chrome://tracing. Begin/end pairs become spans on the
+// thread's track and may nest.
+//
+// Each thread owns a ring of fixed-size binary events {time, name, arg,
+// phase}. Recording one is a clock read and a few plain stores into the
+// thread's own ring: no lock, no read-modify-write atomic, no stdio, and no
+// cache line shared with other threads. When the ring is full the oldest
+// events are overwritten, so the file holds the last `events_per_thread`
+// events of each thread.
+//
+// Only the name pointer is stored, so names must be string literals (or
+// otherwise live until exit) and must not need JSON escaping. Without
+// trace_init, or in a thread that never called trace_thread, every call is
+// one branch.
+//
+// The export runs from an atexit() hook. The rings are never freed, so a
+// thread still running then can go on recording safely, but it may overwrite
+// events while they are written out; join threads first for a clean trace.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+// ============================================================================
+//                                CONFIGURATION
+// ============================================================================
+#define TRACE_NAME_LEN  40   // thread name, as shown on its track
+
+// ============================================================================
+//                                    TYPES
+// ============================================================================
+typedef struct {
+    long long   ts;          // now_ns()
+    const char *name;
+    int32_t     arg;
+    char        phase;       // 'B' begin, 'E' end, 'i' instant
+} trace_event_t;
+
+typedef struct trace_buf {
+    CACHE_ALIGNED atomic_size_t count;   // events ever recorded (owner writes)
+    size_t            mask;              // ring capacity - 1
+    int               tid;
+    char              name[TRACE_NAME_LEN];
+    struct trace_buf *next;              // registry, newest first
+    trace_event_t     events[];
+} trace_buf_t;
+
+static struct {
+    const char              *path;       // NULL = tracing off
+    size_t                   cap;
+    long long                t0;
+    _Atomic(trace_buf_t *)   bufs;
+    atomic_int               next_tid;
+} trace_state;
+
+static _Thread_local trace_buf_t *trace_self;
+
+static void trace_dump(void);
+
+// ============================================================================
+//                                    SETUP
+// ----------------------------------------------------------------------------
+// Returns 0, or -1 if the exit hook cannot be registered.
+// ============================================================================
+static inline int trace_init(const char *path, size_t events_per_thread) {
+    size_t cap = 2;
+    while (cap < events_per_thread)
+        cap <<= 1;
+
+    trace_state.cap = cap;
+    trace_state.t0  = now_ns();
+    atomic_init(&trace_state.bufs, NULL);
+    atomic_init(&trace_state.next_tid, 0);
+    if (atexit(trace_dump) != 0)
+        return -1;
+    trace_state.path = path;
+    return 0;
+}
+
+// Gives the calling thread its ring and a name (printf-style).
+// On allocation failure the thread simply isn't traced.
+static inline void trace_thread(const char *fmt, ...) {
+    if (!trace_state.path || trace_self)
+        return;
+
+    size_t bytes = sizeof(trace_buf_t) + sizeof(trace_event_t) * trace_state.cap;
+    trace_buf_t *b = aligned_alloc(CACHE_LINE, (bytes + CACHE_LINE - 1) & ~(size_t)(CACHE_LINE - 1));
+    if (!b) {
+        perror("trace_thread");
+        return;
+    }
+    atomic_init(&b->count, 0);
+    b->mask = trace_state.cap - 1;
+    b->tid  = atomic_fetch_add_explicit(&trace_state.next_tid, 1, memory_order_relaxed) + 1;
+
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(b->name, sizeof(b->name), fmt, ap);
+    va_end(ap);
+
+    // push onto the registry (once per thread, so a plain CAS loop is fine)
+    b->next = atomic_load_explicit(&trace_state.bufs, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&trace_state.bufs, &b->next, b,
+                                                  memory_order_release,
+                                                  memory_order_relaxed))
+        ;
+    trace_self = b;
+}
+
+// ============================================================================
+//                                  RECORDING
+// ============================================================================
+static inline void trace_record(char phase, const char *name, int32_t arg) {
+    trace_buf_t *b = trace_self;
+    if (!b)
+        return;
+
+    size_t n = atomic_load_explicit(&b->count, memory_order_relaxed);
+    trace_event_t *e = &b->events[n & b->mask];
+    e->ts    = now_ns();
+    e->name  = name;
+    e->arg   = arg;
+    e->phase = phase;
+    atomic_store_explicit(&b->count, n + 1, memory_order_release);
+}
+
+static inline void trace_begin(const char *name)              { trace_record('B', name, 0); }
+static inline void trace_end(const char *name)                { trace_record('E', name, 0); }
+static inline void trace_instant(const char *name, int32_t a) { trace_record('i', name, a); }
+
+// ============================================================================
+//                                   EXPORT
+// ----------------------------------------------------------------------------
+// Chrome trace event format: one JSON object per event, ts in microseconds.
+// ============================================================================
+static void trace_dump(void) {
+    if (!trace_state.path)
+        return;
+
+    FILE *f = fopen(trace_state.path, "w");
+    if (!f) {
+        perror(trace_state.path);
+        return;
+    }
+
+    size_t written = 0, lost = 0;
+    int    threads = 0;
+    const char *sep = "";
+    fprintf(f, "{\"traceEvents\":[\n");
+
+    trace_buf_t *b = atomic_load_explicit(&trace_state.bufs, memory_order_acquire);
+    while (b) {
+        size_t count = atomic_load_explicit(&b->count, memory_order_acquire);
+        size_t first = count > b->mask + 1 ? count - (b->mask + 1) : 0;
+
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                   "\"args\":{\"name\":\"%s\"}}", sep, b->tid, b->name);
+        sep = ",\n";
+        for (size_t n = first; n < count; n++) {
+            trace_event_t *e = &b->events[n & b->mask];
+            fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d",
+                    e->name, e->phase, (e->ts - trace_state.t0) / 1e3, b->tid);
+            if (e->phase == 'i')
+                fprintf(f, ",\"s\":\"t\",\"args\":{\"arg\":%d}", (int)e->arg);
+            fputc('}', f);
+        }
+        written += count - first;
+        lost    += first;
+        threads++;
+
+        b = b->next;   // rings stay allocated: other threads may still record
+    }
+    fprintf(f, "\n]}\n");
+    fclose(f);
+
+    fprintf(stderr, "trace: %zu events from %d threads -> %s (%zu older ones overwritten)\n",
+            written, threads, trace_state.path, lost);
+    trace_state.path = NULL;
+}
+
+#endif // TRACE_H